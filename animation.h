@@ -0,0 +1,76 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include "globals.h"
+#include "components.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// The sprite each clip plays
+inline sprite* const ANIMATION_CLIPS[ANIMATION_CLIP_COUNT] = {
+    &coin_sprite, &player_walk_forward_sprite, &player_walk_backwards_sprite, &enemy_walk
+};
+
+// Ticks a single pass through the frames takes
+[[nodiscard]] size_t sprite_period(const sprite &sprite);
+// The frame shown the given number of ticks after the sprite started
+[[nodiscard]] size_t sprite_frame(const sprite &sprite, size_t ticks);
+[[nodiscard]] size_t animation_frame(const Animation &animation);
+
+// Starts another clip from the beginning; playing the current clip again keeps it going
+void play_animation(Animation &animation, animation_clip clip);
+
+// Moves every clock on by one tick of the fixed timestep. Drawing only reads the clocks, so this
+// is the whole cost of animating, a few instructions per instance.
+void step_animations(Animation *animations, size_t count);
+
+void draw_animation(const Animation &animation, Vector2 pos, float size);
+
+// --- Inline Definitions ---
+
+inline size_t sprite_period(const sprite &sprite) {
+    return sprite.frame_count * (sprite.frames_to_skip + 1);
+}
+
+inline size_t sprite_frame(const sprite &sprite, const size_t ticks) {
+    if (sprite.frame_count == 0) return 0;
+
+    const size_t frame = ticks / (sprite.frames_to_skip + 1);
+    return sprite.loop ? frame % sprite.frame_count : std::min(frame, sprite.frame_count - 1);
+}
+
+inline size_t animation_frame(const Animation &animation) {
+    return sprite_frame(*ANIMATION_CLIPS[animation.clip], size_t{animation.time} + animation.phase);
+}
+
+inline void play_animation(Animation &animation, const animation_clip clip) {
+    if (animation.clip == clip) return;
+    animation.clip = clip;
+    animation.time = 0;
+}
+
+inline void step_animations(Animation *animations, const size_t count) {
+    // Where each clip's clock goes after its last tick: back to the start of a loop, or nowhere
+    uint16_t last_ticks[ANIMATION_CLIP_COUNT];
+    uint16_t after_last_ticks[ANIMATION_CLIP_COUNT];
+    for (size_t clip = 0; clip < ANIMATION_CLIP_COUNT; ++clip) {
+        const sprite &frames = *ANIMATION_CLIPS[clip];
+        const size_t period = std::min<size_t>(sprite_period(frames), UINT16_MAX);
+        last_ticks[clip] = static_cast<uint16_t>(period > 0 ? period - 1 : 0);
+        after_last_ticks[clip] = frames.loop ? 0 : last_ticks[clip];
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        Animation &animation = animations[i];
+        animation.time = animation.time < last_ticks[animation.clip]
+            ? static_cast<uint16_t>(animation.time + 1)
+            : after_last_ticks[animation.clip];
+    }
+}
+
+inline void draw_animation(const Animation &animation, const Vector2 pos, const float size) {
+    draw_sprite(*ANIMATION_CLIPS[animation.clip], animation_frame(animation), pos, size);
+}
+
+#endif // ANIMATION_H
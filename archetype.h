@@ -0,0 +1,156 @@
+#ifndef ARCHETYPE_H
+#define ARCHETYPE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+// Entities that all have the same components, stored as one contiguous array per component.
+// An entity is just its index; removing one moves the last entity into its slot, so indices
+// held elsewhere (e.g. in a ColumnGrid) have to be relabelled the same way. Systems go through
+// for_each and only touch the arrays of the components they ask for.
+template <typename... Components>
+class Archetype {
+public:
+    static_assert(sizeof...(Components) > 0, "An archetype needs at least one component");
+
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] bool empty() const;
+
+    void reserve(size_t count);
+    // New entities get value-initialized components
+    void resize(size_t count);
+    void clear();
+
+    // Returns the new entity's index
+    uint32_t push_back(const Components&... components);
+    // Moves the last entity into the removed one's slot
+    void swap_remove(size_t index);
+
+    template <typename Component>
+    [[nodiscard]] Component& get(size_t index);
+    template <typename Component>
+    [[nodiscard]] const Component& get(size_t index) const;
+
+    // The whole array of one component, for kernels that want raw pointers
+    template <typename Component>
+    [[nodiscard]] Component* data();
+    template <typename Component>
+    [[nodiscard]] const Component* data() const;
+
+    // Calls visit(component&...) for every entity, with the components listed
+    template <typename... Selected, typename Visitor>
+    void for_each(Visitor &&visit);
+    template <typename... Selected, typename Visitor>
+    void for_each(Visitor &&visit) const;
+
+private:
+    template <typename Component>
+    [[nodiscard]] std::vector<Component>& column();
+    template <typename Component>
+    [[nodiscard]] const std::vector<Component>& column() const;
+
+    std::tuple<std::vector<Components>...> columns;
+};
+
+// --- Inline Definitions ---
+
+template <typename... Components>
+inline size_t Archetype<Components...>::size() const {
+    return std::get<0>(columns).size();
+}
+
+template <typename... Components>
+inline bool Archetype<Components...>::empty() const {
+    return size() == 0;
+}
+
+template <typename... Components>
+inline void Archetype<Components...>::reserve(const size_t count) {
+    (column<Components>().reserve(count), ...);
+}
+
+template <typename... Components>
+inline void Archetype<Components...>::resize(const size_t count) {
+    (column<Components>().resize(count), ...);
+}
+
+template <typename... Components>
+inline void Archetype<Components...>::clear() {
+    (column<Components>().clear(), ...);
+}
+
+template <typename... Components>
+inline uint32_t Archetype<Components...>::push_back(const Components&... components) {
+    (column<Components>().push_back(components), ...);
+    return static_cast<uint32_t>(size() - 1);
+}
+
+template <typename... Components>
+inline void Archetype<Components...>::swap_remove(const size_t index) {
+    auto remove = [index](auto &values) {
+        values[index] = values.back();
+        values.pop_back();
+    };
+    (remove(column<Components>()), ...);
+}
+
+template <typename... Components>
+template <typename Component>
+inline Component& Archetype<Components...>::get(const size_t index) {
+    return column<Component>()[index];
+}
+
+template <typename... Components>
+template <typename Component>
+inline const Component& Archetype<Components...>::get(const size_t index) const {
+    return column<Component>()[index];
+}
+
+template <typename... Components>
+template <typename Component>
+inline Component* Archetype<Components...>::data() {
+    return column<Component>().data();
+}
+
+template <typename... Components>
+template <typename Component>
+inline const Component* Archetype<Components...>::data() const {
+    return column<Component>().data();
+}
+
+template <typename... Components>
+template <typename... Selected, typename Visitor>
+inline void Archetype<Components...>::for_each(Visitor &&visit) {
+    const size_t count = size();
+    const std::tuple<Selected*...> arrays{data<Selected>()...};
+    for (size_t i = 0; i < count; ++i) {
+        visit(std::get<Selected*>(arrays)[i]...);
+    }
+}
+
+template <typename... Components>
+template <typename... Selected, typename Visitor>
+inline void Archetype<Components...>::for_each(Visitor &&visit) const {
+    const size_t count = size();
+    const std::tuple<const Selected*...> arrays{data<Selected>()...};
+    for (size_t i = 0; i < count; ++i) {
+        visit(std::get<const Selected*>(arrays)[i]...);
+    }
+}
+
+template <typename... Components>
+template <typename Component>
+inline std::vector<Component>& Archetype<Components...>::column() {
+    // std::get by type only compiles when the component is in the archetype exactly once
+    return std::get<std::vector<Component>>(columns);
+}
+
+template <typename... Components>
+template <typename Component>
+inline const std::vector<Component>& Archetype<Components...>::column() const {
+    return std::get<std::vector<Component>>(columns);
+}
+
+#endif // ARCHETYPE_H
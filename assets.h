@@ -3,11 +3,15 @@
 
 #include "raylib.h"
 #include "globals.h"
+#include "trace.h"
+#include "audio_thread.h"
+#include "sound_bank.h"
 
 #include <string>
 #include <cassert>
 
 void load_fonts() {
+    TRACE_ZONE("load_fonts");
     menu_font = LoadFontEx("data/fonts/ARCADE_N.ttf", 256, nullptr, 128);
 }
 
@@ -16,6 +20,8 @@ void unload_fonts() {
 }
 
 void load_images() {
+    TRACE_ZONE("load_images");
+
     wall_image                   = LoadTexture("data/images/wall_dark.png");
     wall_dark_image              = LoadTexture("data/images/swamp.png");
     spike_image                  = LoadTexture("data/images/tina.png");
@@ -70,6 +76,11 @@ void draw_image(Texture2D image, Vector2 pos, float size) {
 void draw_image(Texture2D image, Vector2 pos, float width, float height) {
     Rectangle source = { 0.0f, 0.0f, static_cast<float>(image.width), static_cast<float>(image.height) };
     Rectangle destination = { pos.x, pos.y, width, height };
+    ++current_frame_counters.draw_calls;
+    if (draw_command_capture != nullptr) {
+        draw_command_capture->push_back({image.id, destination});
+        return;
+    }
     DrawTexturePro(image, source, destination, { 0.0f, 0.0f }, 0.0f, WHITE);
 }
 
@@ -83,7 +94,7 @@ sprite load_sprite(
     assert(frame_count < 100);
 
     sprite result = {
-        frame_count, frames_to_skip, 0, 0, loop, 0, new Texture2D[frame_count]
+        frame_count, frames_to_skip, loop, new Texture2D[frame_count]
     };
 
     for (size_t i = 0; i < frame_count; ++i) {
@@ -113,46 +124,38 @@ void unload_sprite(sprite &sprite) {
     sprite.frames = nullptr;
 }
 
-void draw_sprite(sprite &sprite, Vector2 pos, float size) {
-    draw_sprite(sprite, pos, size, size);
+void draw_sprite(const sprite &sprite, size_t frame_index, Vector2 pos, float size) {
+    draw_sprite(sprite, frame_index, pos, size, size);
 }
 
-void draw_sprite(sprite &sprite, Vector2 pos, float width, float height) {
-    draw_image(sprite.frames[sprite.frame_index], pos, width, height);
-
-    if (sprite.prev_game_frame == game_frame) {
-        return;
-    }
-    if (sprite.frames_skipped < sprite.frames_to_skip) {
-        ++sprite.frames_skipped;
-    } else {
-        sprite.frames_skipped = 0;
-
-        ++sprite.frame_index;
-        if (sprite.frame_index >= sprite.frame_count) {
-            sprite.frame_index = sprite.loop ? 0 : sprite.frame_count - 1;
-        }
-    }
-    sprite.prev_game_frame = game_frame;
+void draw_sprite(const sprite &sprite, size_t frame_index, Vector2 pos, float width, float height) {
+    draw_image(sprite.frames[frame_index], pos, width, height);
 }
 
 void load_sounds() {
+    TRACE_ZONE("load_sounds");
+
     InitAudioDevice();
-    music = LoadMusicStream("data/sounds/music.wav");
-    PlayMusicStream(music);
-    coin_sound         = LoadSound("data/sounds/coin.wav");
-    exit_sound         = LoadSound("data/sounds/exit.wav");
-    kill_enemy_sound   = LoadSound("data/sounds/kill_enemy.wav");
-    player_death_sound = LoadSound("data/sounds/player_death.wav");
-    game_over_sound    = LoadSound("data/sounds/game_over.wav");
+    SoundBank &sounds = SoundBank::getInstance();
+    sounds.set_memory_budget(AUDIO_MEMORY_BUDGET);
+    sounds.load_music("data/sounds/music");
+
+    // Voices per effect: coins come in quick bursts, e.g. the exit timer bonus
+    sounds.load(COIN_SOUND,         "data/sounds/coin",         8);
+    sounds.load(EXIT_SOUND,         "data/sounds/exit",         1);
+    sounds.load(KILL_ENEMY_SOUND,   "data/sounds/kill_enemy",   4);
+    sounds.load(PLAYER_DEATH_SOUND, "data/sounds/player_death", 1);
+    sounds.load(GAME_OVER_SOUND,    "data/sounds/game_over",    1);
+    TraceLog(LOG_INFO, "AUDIO: %zu KB of decoded sounds resident out of %zu KB, %zu streamed",
+             sounds.get_resident_bytes() / 1024, sounds.get_memory_budget() / 1024, sounds.get_streamed_count());
+
+    // From here on only the audio thread touches the audio device
+    AudioThread::getInstance().start();
 }
 
 void unload_sounds() {
-    UnloadSound(coin_sound);
-    UnloadSound(exit_sound);
-    UnloadSound(kill_enemy_sound);
-    UnloadSound(player_death_sound);
-    UnloadSound(game_over_sound);
+    AudioThread::getInstance().stop();
+    SoundBank::getInstance().unload();
 }
 
 #endif // IMAGES_H
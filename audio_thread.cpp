@@ -0,0 +1,65 @@
+#include "audio_thread.h"
+#include "trace.h"
+
+AudioThread::~AudioThread() {
+    stop();
+}
+
+void AudioThread::start() {
+    stop();
+
+    stopping.store(false);
+    worker = std::thread(&AudioThread::run, this);
+}
+
+void AudioThread::stop() {
+    if (!worker.joinable()) return;
+    stopping.store(true);
+    worker.join();
+}
+
+bool AudioThread::is_running() const {
+    return worker.joinable();
+}
+
+size_t AudioThread::get_dropped_count() const {
+    return dropped.load(std::memory_order_relaxed);
+}
+
+void AudioThread::play(sound_id sound) {
+    push({PLAY_SOUND, sound});
+}
+
+void AudioThread::stop_sound(sound_id sound) {
+    push({STOP_SOUND, sound});
+}
+
+void AudioThread::set_muted(bool is_muted) {
+    muted = is_muted;
+}
+
+void AudioThread::push(const command &next) {
+    // Without the thread (e.g. in the tools) there is no audio device to play on
+    if (!is_running() || muted) return;
+    if (!commands.push(next)) dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AudioThread::run() {
+    TRACE_THREAD_NAME("audio");
+    SoundBank &sounds = SoundBank::getInstance();
+
+    while (!stopping.load()) {
+        command next{};
+        while (commands.pop(next)) {
+            if (next.kind == PLAY_SOUND) sounds.play(next.sound);
+            else sounds.stop(next.sound);
+        }
+
+        {
+            TRACE_ZONE("update_streams");
+            sounds.update_streams();
+        }
+
+        std::this_thread::sleep_for(UPDATE_INTERVAL);
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef AUDIO_THREAD_H
+#define AUDIO_THREAD_H
+
+#include "raylib.h"
+#include "sound_bank.h"
+#include "spsc_queue.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+// Makes every audio call once the sounds are loaded: it keeps the streams of the sound bank
+// refilled and plays the sounds gameplay asks for. Gameplay only pushes commands into a lock-free queue,
+// so it never waits on the audio device, and the music carries on through long frames.
+class AudioThread {
+public:
+    static constexpr size_t QUEUE_CAPACITY = 64;
+    static constexpr std::chrono::milliseconds UPDATE_INTERVAL{2};
+
+    [[nodiscard]] static AudioThread &getInstance() {
+        static AudioThread instance;
+        return instance;
+    }
+
+    AudioThread(const AudioThread&) = delete;
+    AudioThread& operator=(const AudioThread&) = delete;
+
+    // Takes over the loaded sound bank
+    void start();
+    void stop();
+
+    // Called from the game thread only. Neither waits: when the queue is full the command is dropped.
+    void play(sound_id sound);
+    void stop_sound(sound_id sound);
+    // While muted, commands are dropped without counting, e.g. while rollback resimulates frames already heard
+    void set_muted(bool is_muted);
+
+    [[nodiscard]] bool is_running() const;
+    [[nodiscard]] size_t get_dropped_count() const;
+
+private:
+    AudioThread() = default;
+    ~AudioThread();
+
+    enum command_kind : uint8_t {
+        PLAY_SOUND,
+        STOP_SOUND
+    };
+
+    struct command {
+        command_kind kind;
+        sound_id sound;
+    };
+
+    void push(const command &next);
+    void run();
+
+    SpscQueue<command, QUEUE_CAPACITY> commands;
+    std::atomic<bool> stopping{false};
+    std::atomic<size_t> dropped{0};
+    bool muted = false; // Only touched by the game thread
+    std::thread worker;
+};
+
+#endif // AUDIO_THREAD_H
@@ -0,0 +1,131 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "heap_counter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/* Microbenchmark Harness */
+
+struct bench_result {
+    std::string name;
+    double ns_per_op;
+    double ops_per_sec;
+    double allocs_per_op;
+};
+
+inline std::vector<bench_result> bench_results;
+inline std::string bench_filter;
+inline volatile float bench_sink; // Results land here so the optimizer cannot drop the work
+
+// Every case is timed in several samples and the median is kept, so one noisy sample
+// does not show up as a regression
+inline const int BENCH_SAMPLES = 5;
+inline const double BENCH_MIN_SAMPLE_SECONDS = 0.05;
+
+// Runs fn, which performs ops_per_call operations, until enough time has passed to trust the average
+template <typename Fn>
+void run_bench(const std::string &name, size_t ops_per_call, Fn &&fn) {
+    if (!bench_filter.empty() && name.find(bench_filter) == std::string::npos) return;
+
+    using clock = std::chrono::steady_clock;
+    fn(); // Warm up caches and lazily sized buffers
+
+    std::vector<double> samples;
+    size_t total_calls = 0;
+    size_t allocations = heap_allocation_count.load();
+    for (int sample = 0; sample < BENCH_SAMPLES; ++sample) {
+        size_t calls = 0;
+        double elapsed = 0.0;
+        clock::time_point start = clock::now();
+        do {
+            fn();
+            ++calls;
+            elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        } while (elapsed < BENCH_MIN_SAMPLE_SECONDS);
+
+        samples.push_back(elapsed * 1e9 / (static_cast<double>(calls) * static_cast<double>(ops_per_call)));
+        total_calls += calls;
+    }
+    allocations = heap_allocation_count.load() - allocations;
+
+    std::sort(samples.begin(), samples.end());
+    double ns_per_op = samples[samples.size() / 2];
+    double total_ops = static_cast<double>(total_calls) * static_cast<double>(ops_per_call);
+    bench_result result = {name, ns_per_op, 1e9 / ns_per_op, static_cast<double>(allocations) / total_ops};
+    std::printf("%-40s %12.2f ns/op %14.0f ops/s %10.2f allocs/op\n",
+                result.name.c_str(), result.ns_per_op, result.ops_per_sec, result.allocs_per_op);
+    bench_results.push_back(result);
+}
+
+/* Results Files */
+
+// One result per line, so a baseline can be read back without a JSON library
+inline void write_bench_json(const std::string &path, const std::vector<bench_result> &results) {
+    std::ofstream file(path);
+    file << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        char line[512];
+        std::snprintf(line, sizeof(line),
+                      "    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"ops_per_sec\": %.1f, \"allocs_per_op\": %.4f}%s\n",
+                      results[i].name.c_str(), results[i].ns_per_op, results[i].ops_per_sec, results[i].allocs_per_op,
+                      i + 1 < results.size() ? "," : "");
+        file << line;
+    }
+    file << "  ]\n}\n";
+}
+
+// Reads back what write_bench_json wrote
+inline std::vector<bench_result> read_bench_json(const std::string &path) {
+    std::vector<bench_result> results;
+    std::ifstream file(path);
+    std::string line;
+
+    auto number_after = [&](const std::string &key) {
+        size_t at = line.find("\"" + key + "\": ");
+        return at == std::string::npos ? 0.0 : std::strtod(line.c_str() + at + key.size() + 4, nullptr);
+    };
+
+    while (std::getline(file, line)) {
+        size_t name_start = line.find("\"name\": \"");
+        if (name_start == std::string::npos) continue;
+        name_start += 9;
+        size_t name_end = line.find('"', name_start);
+        results.push_back({line.substr(name_start, name_end - name_start),
+                           number_after("ns_per_op"), number_after("ops_per_sec"), number_after("allocs_per_op")});
+    }
+    return results;
+}
+
+// Prints every case that got slower by more than the threshold, or allocates more, than in the baseline.
+// Returns the number of regressions.
+inline int compare_bench_results(const std::vector<bench_result> &baseline, const std::vector<bench_result> &results,
+                                 double threshold) {
+    int regressions = 0;
+    for (const bench_result &result : results) {
+        auto before = std::find_if(baseline.begin(), baseline.end(), [&](const bench_result &old) {
+            return old.name == result.name;
+        });
+        if (before == baseline.end()) {
+            std::printf("%-40s %12s\n", result.name.c_str(), "new");
+            continue;
+        }
+
+        double change = result.ns_per_op / before->ns_per_op - 1.0;
+        bool slower = change > threshold;
+        bool allocates_more = result.allocs_per_op > before->allocs_per_op + 0.01;
+        const char *verdict = slower || allocates_more ? "REGRESSION" : change < -threshold ? "faster" : "same";
+        std::printf("%-40s %+11.1f%% %10.2f -> %.2f allocs/op  %s\n", result.name.c_str(), change * 100.0,
+                    before->allocs_per_op, result.allocs_per_op, verdict);
+        regressions += slower || allocates_more;
+    }
+    return regressions;
+}
+
+#endif // BENCH_H
@@ -0,0 +1,404 @@
+#include "raylib.h"
+#include "globals.h"
+#include "level_controller.h"
+#include "enemies_controller.h"
+#include "player.h"
+#include "graphics.h"
+#include "assets.h"
+#include "game.h"
+#include "rollback.h"
+#include "bench.h"
+
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+/* Synthetic Levels */
+
+// A 10-row level with walls every 16 columns and enemies pacing between them, 32 per 16 columns
+std::string make_enemy_level_rle(size_t enemy_count) {
+    size_t segments = (enemy_count + 31) / 32;
+
+    std::string segment = "#&---&---&---&--";
+    std::string enemy_row, wall_row, air_row;
+    for (size_t i = 0; i < segments; ++i) {
+        enemy_row += segment;
+    }
+    enemy_row += "#|";
+
+    std::string rle = std::to_string(segments * 16 + 1) + "-|";
+    for (int row = 0; row < 8; ++row) {
+        rle += enemy_row;
+    }
+    rle += std::to_string(segments * 16 + 1) + "#";
+    return rle;
+}
+
+void load_bench_level(const std::string &rle) {
+    Level level;
+    level.load_from(LevelController::getInstanceLevel().parseLevelRLE(rle));
+    LevelController::getInstanceLevel().set_current_level(level);
+}
+
+/* Enemies */
+
+// The array-of-structs update the enemy store replaced, one sweep per enemy
+struct aos_enemy {
+    Vector2 pos;
+    bool looking_right;
+};
+
+void update_aos_enemies(std::vector<aos_enemy> &enemies) {
+    for (auto &enemy : enemies) {
+        float step = enemy.looking_right ? ENEMY_MOVEMENT_SPEED : -ENEMY_MOVEMENT_SPEED;
+        SweepResult sweep = LevelController::getInstanceLevel().sweep<SOLID_TRAIT>(enemy.pos, {step, 0.0f});
+        if (sweep.hit) {
+            enemy.looking_right = !enemy.looking_right;
+        } else {
+            enemy.pos = sweep.position;
+        }
+    }
+}
+
+void bench_enemies() {
+    const float default_margin = enemy_simulation_margin;
+
+    for (size_t count : {1000, 10000, 100000}) {
+        const std::string rle = make_enemy_level_rle(count);
+
+        // Full simulation of every enemy, against the previous per-enemy update
+        load_bench_level(rle);
+        enemy_simulation_margin = std::numeric_limits<float>::infinity();
+        EnemiesController::getInstance().spawn_enemies();
+        const EnemyStore &store = EnemiesController::getInstance().get_enemies();
+
+        std::vector<aos_enemy> aos;
+        for (size_t i = 0; i < store.size(); ++i) {
+            aos.push_back({store.get_pos(i), store.is_looking_right(i)});
+        }
+
+        run_bench("update_enemies/soa/" + std::to_string(count), store.size(), [] {
+            EnemiesController::getInstance().update_enemies();
+        });
+        run_bench("update_enemies/aos/" + std::to_string(count), aos.size(), [&] {
+            update_aos_enemies(aos);
+        });
+        // Every enemy keeps its own animation clock
+        run_bench("update_animations/" + std::to_string(count), store.size(), [] {
+            EnemiesController::getInstance().update_animations();
+        });
+
+        // Only the enemies around the player are stepped, so the cost per frame should not grow with
+        // the level; walking also pays for putting enemies to sleep and waking them up
+        load_bench_level(rle);
+        enemy_simulation_margin = default_margin;
+        EnemiesController::getInstance().spawn_enemies();
+        const float start_x = static_cast<float>(count / 8); // A quarter into the level
+        Player::getInstancePlayer().set_player_posX(start_x);
+        run_bench("update_enemies/lod/" + std::to_string(count), 1, [] {
+            EnemiesController::getInstance().update_enemies();
+        });
+        run_bench("update_enemies/lod_walking/" + std::to_string(count), 1, [&] {
+            Player &player = Player::getInstancePlayer();
+            float x = player.get_player_posX() + PLAYER_MOVEMENT_SPEED;
+            player.set_player_posX(x < 3.0f * start_x ? x : start_x);
+            EnemiesController::getInstance().update_enemies();
+        });
+    }
+}
+
+/* Dynamic Colliders */
+
+// Walls every 16 columns with a moving platform, a falling block and a moving spike in every gap,
+// three per 16 columns in each of 4 rows, so the density around the player stays the same
+std::string make_dynamic_level_rle(size_t collider_count) {
+    size_t segments = (collider_count + 11) / 12;
+
+    std::string collider_row;
+    for (size_t i = 0; i < segments; ++i) {
+        collider_row += "#-~----%----v---";
+    }
+    collider_row += "#|";
+
+    std::string rle = std::to_string(segments * 16 + 1) + "-|";
+    for (int row = 0; row < 4; ++row) {
+        rle += collider_row + std::to_string(segments * 16 + 1) + "-|";
+    }
+    rle += std::to_string(segments * 16 + 1) + "#";
+    return rle;
+}
+
+void bench_dynamic_colliders() {
+    for (size_t count : {1000, 10000, 100000}) {
+        load_bench_level(make_dynamic_level_rle(count));
+        LevelController &level = LevelController::getInstanceLevel();
+        level.spawn_dynamic_colliders();
+        const size_t spawned = level.get_dynamic_colliders().size();
+
+        run_bench("update_dynamic_colliders/" + std::to_string(count), spawned, [&] {
+            level.update_dynamic_colliders();
+        });
+
+        // Queries from a hitbox in the middle of the level should not care how many colliders there are
+        const Vector2 position = {static_cast<float>(level.get_current_level().get_columns() / 2) + 0.5f, 0.5f};
+        run_bench("query_colliders/sweep/" + std::to_string(count), 1, [&] {
+            SweepResult sweep = level.sweep<SOLID_TRAIT>(position, {PLAYER_MOVEMENT_SPEED, 0.6f});
+            bench_sink += sweep.time;
+        });
+        run_bench("query_colliders/overlaps/" + std::to_string(count), 1, [&] {
+            bench_sink += static_cast<float>(level.is_colliding_with<LETHAL_TRAIT>(position));
+        });
+        run_bench("query_colliders/contacts/" + std::to_string(count), 1, [&] {
+            bench_sink += static_cast<float>(level.query_tiles(position).kinds);
+        });
+    }
+}
+
+/* Chasers */
+
+// A 12-row arena of pillars with the player in the middle and chasers spread around them
+std::string make_chaser_level_rle(size_t chaser_count) {
+    const size_t columns = 128;
+    std::string rle = std::to_string(columns) + "#|";
+    size_t placed = 0;
+    for (size_t row = 1; row < 11; ++row) {
+        std::string line = "#";
+        for (size_t column = 1; column + 1 < columns; ++column) {
+            if (row == 5 && column == columns / 2) {
+                line += "@";
+            } else if (column % 8 == 4 && row % 4 != 1) {
+                line += "#";
+            } else if (placed < chaser_count && (row * columns + column) % 3 == 0) {
+                line += "c";
+                ++placed;
+            } else {
+                line += "-";
+            }
+        }
+        rle += line + "#|";
+    }
+    return rle + std::to_string(columns) + "#";
+}
+
+void bench_chasers() {
+    for (size_t count : {100, 300}) {
+        load_bench_level(make_chaser_level_rle(count));
+        Player::getInstancePlayer().spawn_player();
+        EnemiesController::getInstance().spawn_enemies();
+        const Vector2 start = Player::getInstancePlayer().get_player_pos();
+
+        // The player keeps crossing into new cells, so the field is rebuilt every 10 frames
+        int frame = 0;
+        run_bench("update_chasers/" + std::to_string(count), 1, [&] {
+            Player &player = Player::getInstancePlayer();
+            player.set_player_posX(start.x + static_cast<float>((frame++ % 200) / 10));
+            EnemiesController::getInstance().update_enemies();
+        });
+
+        // The player's enemy query once the chasers have gathered around them
+        run_bench("is_colliding_with_enemies/chasers/" + std::to_string(count), 1, [&] {
+            bench_sink = static_cast<float>(EnemiesController::getInstance().is_colliding_with_enemies(Player::getInstancePlayer().get_player_pos()));
+        });
+    }
+
+    // Rebuilding the field from scratch, which is the worst case for a single frame
+    FlowField field;
+    const Level &level = LevelController::getInstanceLevel().get_current_level();
+    field.reset(level.get_rows(), level.get_columns());
+    long column = 0;
+    run_bench("flow_field/rebuild", 1, [&] {
+        field.update(level.get_bitplanes(), 5, 16 + (column++ % 32));
+    });
+}
+
+/* Endless Levels */
+
+void bench_endless() {
+    LevelGenerator generator(1);
+    PackedTileGrid chunk{LevelGenerator::ROWS, LevelGenerator::CHUNK_COLUMNS};
+    uint64_t chunk_index = 0;
+    run_bench("endless/generate_chunk", 1, [&] {
+        generator.generate(chunk_index++, chunk);
+        bench_sink = static_cast<float>(chunk.get_kind(0, 0));
+    });
+
+    // One scroll of the window with everything in it moving along; the player is kept past the
+    // scroll threshold, so the only wait is for the worker when it falls behind
+    LevelController &level_controller = LevelController::getInstanceLevel();
+    player_level_scores.assign(1, 0);
+    level_controller.start_endless_mode(1);
+    run_bench("endless/scroll", 1, [&] {
+        const long scrolled = level_controller.get_scrolled_columns();
+        while (level_controller.get_scrolled_columns() == scrolled) {
+            Player::getInstancePlayer().set_player_posX(static_cast<float>(level_controller.get_current_level().get_columns()));
+            level_controller.update_endless_level();
+        }
+    });
+    level_controller.stop_endless_mode();
+}
+
+/* Level Corpus */
+
+// Sprites get a single blank frame, since there is no window to load textures into
+Texture2D headless_frame{};
+
+void use_headless_sprites() {
+    for (sprite *headless : {&coin_sprite, &player_walk_forward_sprite, &player_walk_backwards_sprite, &enemy_walk}) {
+        headless->frames = &headless_frame;
+        headless->frame_count = 1;
+    }
+    screen_size = {2048.0f, 1024.0f};
+}
+
+// The game's hot paths on the stress levels in data/corpus; the bench has to run from the repository root
+void bench_corpus() {
+    LevelController &level_controller = LevelController::getInstanceLevel();
+    use_headless_sprites();
+
+    for (const std::string name : {"small", "medium", "huge"}) {
+        const std::string path = "data/corpus/" + name + ".rll";
+        std::ifstream file(path);
+        std::string line, rle;
+        while (rle.empty() && std::getline(file, line)) {
+            if (!line.empty() && line[0] != ';') rle = line;
+        }
+        if (rle.empty()) {
+            std::printf("%-40s skipped, %s not found\n", ("corpus/" + name).c_str(), path.c_str());
+            continue;
+        }
+
+        // Loading
+        run_bench("parse_level_rle/" + name, 1, [&] {
+            bench_sink = static_cast<float>(level_controller.parseLevelRLE(rle).get_run_count());
+        });
+        run_bench("load_levels_from_file/" + name, 1, [&] {
+            bench_sink = static_cast<float>(level_controller.loadLevelsFromFile(path).size());
+        });
+        run_bench("load_level/" + name, 1, [&] {
+            level_index = 0;
+            level_controller.load_level(0);
+        });
+
+        // Saving an edit of the level in play: the file read again, the edited line parsed and the
+        // level swapped in. Every other save adds a comment to the line, so it always differs.
+        const std::filesystem::path edited_path = std::filesystem::temp_directory_path() / ("platformer_bench_" + name + ".rll");
+        size_t saves = 0;
+        game_state = GAME_STATE;
+        level_index = 0;
+        level_controller.load_level(0);
+        run_bench("hot_reload/" + name, 1, [&] {
+            std::ofstream(edited_path) << rle << (++saves % 2 ? ";edited" : "") << '\n';
+            if (level_controller.reloadLevelsFromFile(edited_path.string())) level_controller.reload_current_level();
+        });
+        std::filesystem::remove(edited_path);
+        level_controller.loadLevelsFromFile(path);
+        game_state = MENU_STATE;
+
+        // Spawning consumes the spawn markers, so every call starts from a copy of the untouched level
+        Level pristine;
+        pristine.load_from(level_controller.parseLevelRLE(rle));
+        run_bench("spawn_player/" + name, 1, [&] {
+            level_controller.set_current_level(pristine);
+            Player::getInstancePlayer().spawn_player();
+        });
+        run_bench("spawn_enemies/" + name, 1, [&] {
+            level_controller.set_current_level(pristine);
+            EnemiesController::getInstance().spawn_enemies();
+        });
+
+        level_index = 0;
+        level_controller.load_level(0);
+        const Level &level = level_controller.get_current_level();
+
+        // Queries at fixed pseudo-random spots all over the level
+        std::vector<Vector2> spots(1024);
+        uint32_t seed = 1;
+        for (Vector2 &spot : spots) {
+            seed = seed * 1664525u + 1013904223u;
+            spot.x = static_cast<float>(seed % (level.get_columns() * 10)) / 10.0f;
+            seed = seed * 1664525u + 1013904223u;
+            spot.y = static_cast<float>(seed % (level.get_rows() * 10)) / 10.0f;
+        }
+        size_t spot = 0;
+        run_bench("is_colliding/" + name, 1, [&] {
+            bench_sink = static_cast<float>(level_controller.is_colliding(spots[spot++ % spots.size()], WALL));
+        });
+        run_bench("get_collider/" + name, 1, [&] {
+            bench_sink = static_cast<float>(level_controller.get_collider(spots[spot++ % spots.size()], WALL).column);
+        });
+        run_bench("is_colliding_with_enemies/" + name, 1, [&] {
+            bench_sink = static_cast<float>(EnemiesController::getInstance().is_colliding_with_enemies(spots[spot++ % spots.size()]));
+        });
+
+        // A frame of the moving parts, with the player at the spawn
+        run_bench("update_enemies/corpus/" + name, 1, [&] {
+            level_controller.update_dynamic_colliders();
+            EnemiesController::getInstance().update_enemies();
+        });
+
+        // The longest rollback a session does: back to the snapshot before the mispredicted frame,
+        // then every frame since played again and snapshotted, all within one frame of the game
+        player_count = 2;
+        game_state = GAME_STATE;
+        level_index = 0;
+        level_controller.load_level(0);
+        std::vector<game_snapshot> snapshots(RollbackSession::MAX_ROLLBACK_FRAMES);
+        game_snapshot before;
+        save_game(before);
+        const frame_input inputs[MAX_PLAYERS] = {{1 << MOVE_RIGHT_ACTION, 0}, {1 << MOVE_LEFT_ACTION | 1 << JUMP_ACTION, 0}};
+        run_bench("rollback_8_frames/" + name, 1, [&] {
+            restore_game(before);
+            for (game_snapshot &snapshot : snapshots) {
+                save_game(snapshot);
+                step_game(inputs);
+            }
+        });
+        restore_game(before);
+        player_count = 1;
+        game_state = MENU_STATE;
+
+        // Drawing one screen, recording the blits instead of issuing them
+        std::vector<draw_command> commands;
+        draw_command_capture = &commands;
+        run_bench("draw_level/" + name, 1, [&] {
+            commands.clear();
+            level_controller.draw_level();
+            bench_sink = static_cast<float>(commands.size());
+        });
+        draw_command_capture = nullptr;
+    }
+}
+
+// platformer_bench [filter] [--json results.json] [--compare baseline.json] [--threshold 0.10]
+int main(int argc, char **argv) {
+    std::string json_path, baseline_path;
+    double threshold = 0.10;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--json" && i + 1 < argc) json_path = argv[++i];
+        else if (argument == "--compare" && i + 1 < argc) baseline_path = argv[++i];
+        else if (argument == "--threshold" && i + 1 < argc) threshold = std::stod(argv[++i]);
+        else bench_filter = argument;
+    }
+
+    bench_enemies();
+    bench_dynamic_colliders();
+    bench_chasers();
+    bench_endless();
+    bench_corpus();
+
+    if (!json_path.empty()) write_bench_json(json_path, bench_results);
+    if (baseline_path.empty()) return 0;
+
+    std::vector<bench_result> baseline = read_bench_json(baseline_path);
+    if (baseline.empty()) {
+        std::fprintf(stderr, "No results in %s\n", baseline_path.c_str());
+        return 1;
+    }
+    std::printf("\nAgainst %s (threshold %.0f%%):\n", baseline_path.c_str(), threshold * 100.0);
+    int regressions = compare_bench_results(baseline, bench_results, threshold);
+    std::printf("%d regression(s)\n", regressions);
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,74 @@
+#include "chunk_streamer.h"
+#include "trace.h"
+
+ChunkStreamer::ChunkStreamer() {
+    for (PackedTileGrid &slot : slots) {
+        slot = PackedTileGrid{LevelGenerator::ROWS, LevelGenerator::CHUNK_COLUMNS};
+    }
+}
+
+ChunkStreamer::~ChunkStreamer() {
+    stop();
+}
+
+void ChunkStreamer::start(const LevelGenerator &new_generator, uint64_t first_chunk_index) {
+    stop();
+
+    generator = new_generator;
+    first_chunk = first_chunk_index;
+    produced.store(0);
+    consumed.store(0);
+    stopping = false;
+    worker = std::thread(&ChunkStreamer::run, this);
+}
+
+void ChunkStreamer::stop() {
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    slot_freed.notify_one();
+    worker.join();
+}
+
+bool ChunkStreamer::is_running() const {
+    return worker.joinable();
+}
+
+const PackedTileGrid* ChunkStreamer::peek() const {
+    const uint64_t next = consumed.load(std::memory_order_relaxed);
+    if (next == produced.load(std::memory_order_acquire)) return nullptr;
+    return &slots[next % SLOT_COUNT];
+}
+
+void ChunkStreamer::pop() {
+    consumed.fetch_add(1, std::memory_order_release);
+
+    // Taking the lock for the notify keeps the worker from missing it between its check and its wait;
+    // the worker never holds the lock while generating, so this does not wait on a chunk being built
+    { std::lock_guard<std::mutex> lock(mutex); }
+    slot_freed.notify_one();
+}
+
+void ChunkStreamer::run() {
+    TRACE_THREAD_NAME("chunk streamer");
+
+    for (;;) {
+        uint64_t next = produced.load(std::memory_order_relaxed);
+        {
+            // Wait for a free slot, that is for the game to consume the oldest ready chunk
+            std::unique_lock<std::mutex> lock(mutex);
+            slot_freed.wait(lock, [&] {
+                return stopping || next - consumed.load(std::memory_order_acquire) < SLOT_COUNT;
+            });
+            if (stopping) return;
+        }
+
+        {
+            TRACE_ZONE("generate_chunk");
+            generator.generate(first_chunk + next, slots[next % SLOT_COUNT]);
+        }
+        produced.store(next + 1, std::memory_order_release);
+    }
+}
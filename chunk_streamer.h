@@ -0,0 +1,56 @@
+#ifndef CHUNK_STREAMER_H
+#define CHUNK_STREAMER_H
+
+#include "level_generator.h"
+#include "tile_grid.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Generates the chunks ahead of the player on a worker thread. Finished chunks wait in a
+// fixed ring of buffers that are reused once the game has copied them into the level, so
+// streaming never allocates. The game only ever polls: when the next chunk is not ready
+// yet it carries on and tries again next frame instead of waiting for the worker.
+class ChunkStreamer {
+public:
+    static constexpr size_t SLOT_COUNT = 4;
+
+    ChunkStreamer();
+    ~ChunkStreamer();
+
+    ChunkStreamer(const ChunkStreamer&) = delete;
+    ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+    // Starts generating from the given chunk on, stopping any previous run first
+    void start(const LevelGenerator &generator, uint64_t first_chunk_index);
+    void stop();
+
+    // The next chunk in order, or nullptr if the worker has not finished it yet
+    [[nodiscard]] const PackedTileGrid* peek() const;
+    // Hands the chunk returned by peek() back to the worker
+    void pop();
+
+    [[nodiscard]] bool is_running() const;
+
+private:
+    void run();
+
+    LevelGenerator generator;
+    std::array<PackedTileGrid, SLOT_COUNT> slots;
+
+    // Chunks generated and consumed since start(); the worker owns the slots in between
+    std::atomic<uint64_t> produced{0};
+    std::atomic<uint64_t> consumed{0};
+    uint64_t first_chunk = 0;
+
+    std::mutex mutex;
+    std::condition_variable slot_freed;
+    bool stopping = false;
+    std::thread worker;
+};
+
+#endif // CHUNK_STREAMER_H
@@ -0,0 +1,135 @@
+#ifndef COLUMN_GRID_H
+#define COLUMN_GRID_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+// Uniform grid of entity indices keyed by tile column, the broadphase for enemies and
+// moving colliders. Every column is an intrusive doubly linked list, so moving, removing
+// and relabelling an entity are all O(1) and a query only walks the columns it asks for.
+class ColumnGrid {
+public:
+    static constexpr int32_t NONE = -1;
+
+    void reset(size_t column_count);
+    void reserve(size_t entity_count);
+
+    void insert(uint32_t index, float x);
+    void remove(uint32_t index);
+    void move(uint32_t index, float x);
+
+    // The entity stored at from_index now lives at to_index (used by swap-and-pop)
+    void relabel(uint32_t from_index, uint32_t to_index);
+
+    // Calls visit(index) for every entity whose column lies within [first_x, last_x]
+    template <typename Visitor>
+    void for_each_in_range(float first_x, float last_x, Visitor &&visit) const;
+
+    [[nodiscard]] size_t get_column_count() const;
+
+private:
+    [[nodiscard]] uint32_t column_of(float x) const;
+    void link(uint32_t index, uint32_t column);
+    void unlink(uint32_t index);
+
+    std::vector<int32_t> heads;
+    std::vector<int32_t> next;
+    std::vector<int32_t> prev;
+    std::vector<uint32_t> columns;
+};
+
+// --- Inline Definitions ---
+
+inline void ColumnGrid::reset(size_t column_count) {
+    heads.assign(std::max<size_t>(column_count, 1), NONE);
+    next.clear();
+    prev.clear();
+    columns.clear();
+}
+
+inline void ColumnGrid::reserve(size_t entity_count) {
+    next.reserve(entity_count);
+    prev.reserve(entity_count);
+    columns.reserve(entity_count);
+}
+
+inline size_t ColumnGrid::get_column_count() const {
+    return heads.size();
+}
+
+inline uint32_t ColumnGrid::column_of(float x) const {
+    // Keep entities that stray off the level in the edge columns
+    if (x <= 0.0f) return 0;
+    return static_cast<uint32_t>(std::min(static_cast<size_t>(x), heads.size() - 1));
+}
+
+inline void ColumnGrid::link(uint32_t index, uint32_t column) {
+    columns[index] = column;
+    prev[index] = NONE;
+    next[index] = heads[column];
+    if (heads[column] != NONE) prev[heads[column]] = static_cast<int32_t>(index);
+    heads[column] = static_cast<int32_t>(index);
+}
+
+inline void ColumnGrid::unlink(uint32_t index) {
+    if (prev[index] != NONE) next[prev[index]] = next[index];
+    else heads[columns[index]] = next[index];
+    if (next[index] != NONE) prev[next[index]] = prev[index];
+}
+
+inline void ColumnGrid::insert(uint32_t index, float x) {
+    if (index >= columns.size()) {
+        columns.resize(index + 1);
+        next.resize(index + 1, NONE);
+        prev.resize(index + 1, NONE);
+    }
+    link(index, column_of(x));
+}
+
+inline void ColumnGrid::remove(uint32_t index) {
+    unlink(index);
+    if (index + 1 == columns.size()) {
+        columns.pop_back();
+        next.pop_back();
+        prev.pop_back();
+    }
+}
+
+inline void ColumnGrid::move(uint32_t index, float x) {
+    uint32_t column = column_of(x);
+    if (column == columns[index]) return;
+    unlink(index);
+    link(index, column);
+}
+
+inline void ColumnGrid::relabel(uint32_t from, uint32_t to) {
+    columns[to] = columns[from];
+    next[to] = next[from];
+    prev[to] = prev[from];
+    if (prev[to] != NONE) next[prev[to]] = static_cast<int32_t>(to);
+    else heads[columns[to]] = static_cast<int32_t>(to);
+    if (next[to] != NONE) prev[next[to]] = static_cast<int32_t>(to);
+
+    if (from + 1 == columns.size()) {
+        columns.pop_back();
+        next.pop_back();
+        prev.pop_back();
+    }
+}
+
+template <typename Visitor>
+inline void ColumnGrid::for_each_in_range(float first_x, float last_x, Visitor &&visit) const {
+    // A grid that was never reset has no columns to visit
+    if (last_x < 0.0f || heads.empty()) return;
+    uint32_t first = column_of(first_x);
+    uint32_t last = column_of(last_x);
+    for (uint32_t column = first; column <= last; ++column) {
+        for (int32_t index = heads[column]; index != NONE; index = next[index]) {
+            visit(static_cast<uint32_t>(index));
+        }
+    }
+}
+
+#endif // COLUMN_GRID_H
@@ -0,0 +1,54 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include "raylib.h"
+#include <cstdint>
+
+// Components of the entities kept in archetypes (see archetype.h), in tiles and frames
+
+struct Position {
+    Vector2 value; // Top left corner of the 1x1 hitbox
+};
+
+struct Velocity {
+    Vector2 value; // Per frame
+};
+
+struct GroundContact {
+    bool on_ground;
+    int32_t collider; // The moving collider stood on, or -1
+};
+
+// What the walking animation needs to know
+struct Facing {
+    bool forward;
+    bool moving; // Walked this frame
+};
+
+// The cell centre a chasing enemy is heading for
+struct PathTarget {
+    Vector2 value;
+};
+
+// Animated sprites, see ANIMATION_CLIPS in animation.h
+enum animation_clip : uint8_t {
+    COIN_CLIP,
+    PLAYER_WALK_FORWARD_CLIP,
+    PLAYER_WALK_BACKWARDS_CLIP,
+    ENEMY_WALK_CLIP,
+    ANIMATION_CLIP_COUNT
+};
+
+// An animation clock of its own, so instances of a clip don't all show the same frame
+struct Animation {
+    uint8_t clip;
+    uint8_t phase; // Ticks this instance runs ahead of the clip's start
+    uint16_t time; // Ticks since the clip started, wrapped at the end of a loop
+};
+
+// A phase that spreads instances over the clip's cycle, from anything that tells them apart
+[[nodiscard]] inline uint8_t animation_phase(const uint32_t seed) {
+    return static_cast<uint8_t>((seed * 2654435761u) >> 24);
+}
+
+#endif // COMPONENTS_H
@@ -0,0 +1,304 @@
+#ifndef DYNAMIC_COLLIDERS_H
+#define DYNAMIC_COLLIDERS_H
+
+#include "raylib.h"
+#include "globals.h"
+#include "tiles.h"
+#include "tile_bitplanes.h"
+#include "column_grid.h"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+enum collider_state : uint8_t {
+    MOVING_COLLIDER,  // Platforms and moving spikes pacing back and forth
+    WAITING_COLLIDER, // A falling block nobody has stepped on yet
+    SHAKING_COLLIDER, // A falling block counting down to the drop
+    FALLING_COLLIDER,
+    LANDED_COLLIDER,
+    GONE_COLLIDER     // Fell out of the level
+};
+
+// A moving 1x1 collider that started out as a tile in the level file
+struct DynamicCollider {
+    Vector2 position;
+    Vector2 velocity;          // Per frame
+    Vector2 displacement;      // The last update's move, which carries whatever stands on top
+    uint8_t kind;
+    collider_state state;
+    int timer;
+};
+
+// Moving platforms, falling blocks and moving spikes. They are bucketed by column in a
+// ColumnGrid, so a query only looks at the colliders next to the hitbox asking.
+class DynamicColliders {
+public:
+    void reset(size_t row_count, size_t column_count);
+    void reserve(size_t collider_count);
+    void spawn(uint8_t kind, size_t row_index, size_t column_index, const TileBitplanes &tiles);
+    void update(const TileBitplanes &tiles);
+
+    // Starts the countdown of a falling block that was stepped on
+    void stand_on(int32_t index);
+
+    // The level scrolled left by the given number of columns. Colliders that scrolled off or fell
+    // out are dropped and the rest keep their order; tracked is updated to the same collider's
+    // new index, or -1 if it was dropped.
+    void shift_origin(long columns, int32_t &tracked);
+
+    // The same queries TileBitplanes answers for tiles, against the colliders with the given traits
+    template <uint8_t Traits>
+    [[nodiscard]] bool overlaps(Vector2 position) const;
+    // Narrows down a tile sweep to the first collider hit before it
+    template <uint8_t Traits>
+    void sweep(Vector2 position, Vector2 delta, SweepResult &result) const;
+    void add_contacts(Vector2 position, TileContacts &contacts) const;
+
+    // Whether a moving solid can ever overlap the column; batched kernels that only test the
+    // tile grid use it to find the few entities that need the full query
+    [[nodiscard]] bool may_reach(long column_index) const;
+
+    // Calls visit(collider) for every collider whose column lies within [first_x, last_x]
+    template <typename Visitor>
+    void for_each_in_range(float first_x, float last_x, Visitor &&visit) const;
+
+    [[nodiscard]] const DynamicCollider& get(int32_t index) const;
+    [[nodiscard]] bool empty() const;
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] size_t get_memory_usage() const;
+
+private:
+    template <typename Visitor>
+    void for_each_near(Vector2 position, Vector2 delta, Visitor &&visit) const;
+    void mark_reach(long first_column, long last_column);
+
+    std::vector<DynamicCollider> colliders;
+    ColumnGrid grid;
+    std::vector<uint8_t> reach; // Per column, whether a solid collider ever passes through it
+    size_t rows = 0;
+};
+
+// --- Inline Definitions ---
+
+inline void DynamicColliders::reset(size_t row_count, size_t column_count) {
+    rows = row_count;
+    colliders.clear();
+    grid.reset(column_count);
+    reach.assign(column_count, 0);
+}
+
+inline void DynamicColliders::reserve(size_t collider_count) {
+    colliders.reserve(collider_count);
+    grid.reserve(collider_count);
+}
+
+inline void DynamicColliders::mark_reach(long first_column, long last_column) {
+    first_column = std::max(first_column, 0L);
+    last_column = std::min(last_column, static_cast<long>(reach.size()) - 1);
+    for (long column = first_column; column <= last_column; ++column) {
+        reach[column] = 1;
+    }
+}
+
+inline void DynamicColliders::spawn(uint8_t kind, size_t row, size_t column, const TileBitplanes &tiles) {
+    DynamicCollider collider = {
+        {static_cast<float>(column), static_cast<float>(row)}, {0.0f, 0.0f}, {0.0f, 0.0f}, kind, MOVING_COLLIDER, 0
+    };
+
+    if (kind == MOVING_PLATFORM_TILE) {
+        // Platforms pace between the walls of their row
+        collider.velocity.x = PLATFORM_MOVEMENT_SPEED;
+        long left_wall = static_cast<long>(column) - 1;
+        while (left_wall >= 0 && !tiles.is_solid_column(left_wall, collider.position.y)) --left_wall;
+        long right_wall = static_cast<long>(column) + 1;
+        while (right_wall < static_cast<long>(reach.size()) && !tiles.is_solid_column(right_wall, collider.position.y)) ++right_wall;
+        mark_reach(left_wall + 1, right_wall - 1);
+    } else if (kind == FALLING_BLOCK_TILE) {
+        collider.state = WAITING_COLLIDER;
+        mark_reach(static_cast<long>(column), static_cast<long>(column));
+    } else {
+        // Moving spikes go up and down, starting downwards
+        collider.velocity.y = SPIKE_MOVEMENT_SPEED;
+    }
+
+    colliders.push_back(collider);
+    grid.insert(static_cast<uint32_t>(colliders.size() - 1), collider.position.x);
+}
+
+inline void DynamicColliders::update(const TileBitplanes &tiles) {
+    for (size_t i = 0; i < colliders.size(); ++i) {
+        DynamicCollider &collider = colliders[i];
+        collider.displacement = {0.0f, 0.0f};
+
+        switch (collider.state) {
+            case MOVING_COLLIDER: {
+                // Like enemies, turn around instead of moving when a wall is in the way
+                SweepResult sweep = tiles.sweep<SOLID_TRAIT>(collider.position, collider.velocity);
+                if (sweep.hit) {
+                    collider.velocity = {-collider.velocity.x, -collider.velocity.y};
+                } else {
+                    collider.displacement = collider.velocity;
+                }
+                break;
+            }
+            case SHAKING_COLLIDER:
+                if (--collider.timer <= 0) collider.state = FALLING_COLLIDER;
+                break;
+            case FALLING_COLLIDER: {
+                SweepResult sweep = tiles.sweep<SOLID_TRAIT>(collider.position, collider.velocity);
+                collider.displacement = {0.0f, sweep.position.y - collider.position.y};
+                if (sweep.hit) {
+                    collider.state = LANDED_COLLIDER;
+                    collider.velocity = {0.0f, 0.0f};
+                } else {
+                    collider.velocity.y += GRAVITY_FORCE;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        if (collider.displacement.x == 0.0f && collider.displacement.y == 0.0f) continue;
+
+        collider.position.x += collider.displacement.x;
+        collider.position.y += collider.displacement.y;
+
+        // Blocks that fell through a hole in the floor are dropped from the broadphase
+        if (collider.position.y > static_cast<float>(rows)) {
+            collider.state = GONE_COLLIDER;
+            collider.displacement = {0.0f, 0.0f};
+            grid.remove(static_cast<uint32_t>(i));
+        } else {
+            grid.move(static_cast<uint32_t>(i), collider.position.x);
+        }
+    }
+}
+
+inline void DynamicColliders::stand_on(int32_t index) {
+    DynamicCollider &collider = colliders[index];
+    if (collider.state != WAITING_COLLIDER) return;
+    collider.state = SHAKING_COLLIDER;
+    collider.timer = FALLING_BLOCK_DELAY;
+}
+
+inline void DynamicColliders::shift_origin(long columns, int32_t &tracked) {
+    size_t kept = 0;
+    int32_t tracked_index = -1;
+    for (size_t i = 0; i < colliders.size(); ++i) {
+        DynamicCollider collider = colliders[i];
+        collider.position.x -= static_cast<float>(columns);
+        if (collider.state == GONE_COLLIDER || collider.position.x < 0.0f) continue;
+
+        if (static_cast<int32_t>(i) == tracked) tracked_index = static_cast<int32_t>(kept);
+        colliders[kept++] = collider;
+    }
+    colliders.resize(kept);
+    tracked = tracked_index;
+
+    // The reach moves along with the level; the new columns are marked as their colliders spawn
+    columns = std::min(columns, static_cast<long>(reach.size()));
+    std::copy(reach.begin() + columns, reach.end(), reach.begin());
+    std::fill(reach.end() - columns, reach.end(), 0);
+
+    grid.reset(reach.size());
+    for (size_t i = 0; i < colliders.size(); ++i) {
+        grid.insert(static_cast<uint32_t>(i), colliders[i].position.x);
+    }
+}
+
+template <typename Visitor>
+inline void DynamicColliders::for_each_near(Vector2 pos, Vector2 delta, Visitor &&visit) const {
+    // A collider's column is its truncated x, so one column either side covers every box in reach
+    float low_x = std::min(pos.x, pos.x + delta.x);
+    float high_x = std::max(pos.x, pos.x + delta.x);
+    grid.for_each_in_range(low_x - 1.0f, high_x + 1.0f, [&](uint32_t index) {
+        visit(static_cast<int32_t>(index), colliders[index]);
+    });
+}
+
+template <uint8_t Traits>
+inline bool DynamicColliders::overlaps(Vector2 pos) const {
+    bool overlapping = false;
+    for_each_near(pos, {0.0f, 0.0f}, [&](int32_t, const DynamicCollider &collider) {
+        if ((TILE_KIND_TRAITS[collider.kind] & Traits) != Traits) return;
+        overlapping = overlapping || (std::fabs(collider.position.x - pos.x) < 1.0f &&
+                                      std::fabs(collider.position.y - pos.y) < 1.0f);
+    });
+    return overlapping;
+}
+
+template <uint8_t Traits>
+inline void DynamicColliders::sweep(Vector2 pos, Vector2 delta, SweepResult &result) const {
+    int32_t hit = -1;
+    bool along_x = false;
+    float time = result.time;
+
+    for_each_near(pos, delta, [&](int32_t index, const DynamicCollider &collider) {
+        if ((TILE_KIND_TRAITS[collider.kind] & Traits) != Traits) return;
+
+        float entry_x, exit_x, entry_y, exit_y;
+        if (!sweep_slab(pos.x, delta.x, collider.position.x, entry_x, exit_x)) return;
+        if (!sweep_slab(pos.y, delta.y, collider.position.y, entry_y, exit_y)) return;
+
+        // Same rules as tiles: colliders overlapped at the start are ignored, ties go to the tile
+        float entry = std::max(entry_x, entry_y);
+        float exit  = std::min(exit_x, exit_y);
+        if (entry < 0.0f || entry >= exit || entry >= time) return;
+
+        hit = index;
+        time = entry;
+        along_x = entry_x > entry_y;
+    });
+    if (hit < 0) return;
+
+    const Vector2 obstacle = colliders[hit].position;
+    result.hit = true;
+    result.time = time;
+    result.collider = hit;
+    if (along_x) {
+        result.normal   = {delta.x > 0.0f ? -1.0f : 1.0f, 0.0f};
+        result.position = {obstacle.x + result.normal.x, pos.y + delta.y * time};
+    } else {
+        result.normal   = {0.0f, delta.y > 0.0f ? -1.0f : 1.0f};
+        result.position = {pos.x + delta.x * time, obstacle.y + result.normal.y};
+    }
+}
+
+inline void DynamicColliders::add_contacts(Vector2 pos, TileContacts &contacts) const {
+    for_each_near(pos, {0.0f, 0.0f}, [&](int32_t, const DynamicCollider &collider) {
+        if (std::fabs(collider.position.x - pos.x) < 1.0f && std::fabs(collider.position.y - pos.y) < 1.0f) {
+            contacts.kinds |= 1u << collider.kind;
+        }
+    });
+}
+
+inline bool DynamicColliders::may_reach(long column) const {
+    return column >= 0 && column < static_cast<long>(reach.size()) && reach[column];
+}
+
+template <typename Visitor>
+inline void DynamicColliders::for_each_in_range(float first_x, float last_x, Visitor &&visit) const {
+    grid.for_each_in_range(first_x, last_x, [&](uint32_t index) {
+        visit(colliders[index]);
+    });
+}
+
+inline const DynamicCollider& DynamicColliders::get(int32_t index) const {
+    return colliders[index];
+}
+
+inline bool DynamicColliders::empty() const {
+    return colliders.empty();
+}
+
+inline size_t DynamicColliders::size() const {
+    return colliders.size();
+}
+
+inline size_t DynamicColliders::get_memory_usage() const {
+    return sizeof(*this) + colliders.capacity() * sizeof(DynamicCollider) + reach.capacity();
+}
+
+#endif // DYNAMIC_COLLIDERS_H
@@ -3,82 +3,507 @@
 #include "level.h"
 #include "level_controller.h"
 #include "player.h"
+#include "animation.h"
+#include "trace.h"
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <limits>
+
+// Floor division for the kernels, where positions may sit left of column 0
+static int32_t floor_div(const int32_t value, const int32_t divisor) {
+    return value / divisor - (value % divisor < 0);
+}
+
+// Fast-forwards an enemy pacing between its patrol bounds by the given number of frames.
+// Mirrors update_enemies: a step while the next position stays within the bounds, and a frame
+// spent turning around when it does not, so the patrol repeats with a fixed period.
+static void advance_patrol(EnemyState &enemy, const uint64_t frames) {
+    const int64_t step = ENEMY_MOVEMENT_STEP;
+    const int64_t right_end = enemy.position + (enemy.patrol_hi - enemy.position) / step * step;
+    const int64_t left_end = enemy.position - (enemy.position - enemy.patrol_lo) / step * step;
+    const int64_t steps = (right_end - left_end) / step;
+    const int64_t period = 2 * (steps + 1);
+
+    // Phases [0, steps] walk right from left_end, the rest walk left from right_end
+    int64_t phase = enemy.direction > 0 ? (enemy.position - left_end) / step : steps + 1 + (right_end - enemy.position) / step;
+    phase = (phase + static_cast<int64_t>(frames % static_cast<uint64_t>(period))) % period;
+
+    if (phase <= steps) {
+        enemy.position = static_cast<int32_t>(left_end + phase * step);
+        enemy.direction = 1;
+    } else {
+        enemy.position = static_cast<int32_t>(right_end - (phase - steps - 1) * step);
+        enemy.direction = -1;
+    }
+}
 
 void EnemiesController::spawn_enemies() {
     // Create enemies, incrementing their amount every time a new one is created
     enemies.clear();
+    chasers.clear();
 
-    for (size_t row = 0; row < LevelController::getInstanceLevel().get_current_level().get_rows(); ++row) {
-        for (size_t column = 0; column < LevelController::getInstanceLevel().get_current_level().get_columns(); ++column) {
-            if (char cell = Level::get_level_cell(row, column); cell == ENEMY) {
-                // Instantiate and add an enemy to the level
-                enemies.push_back({
-                        {static_cast<float>(column), static_cast<float>(row)},
-                        true
-                });
+    const Level &level = LevelController::getInstanceLevel().get_current_level();
+    grid.reset(level.get_columns());
+    chaser_grid.reset(level.get_columns());
 
-                LevelController::getInstanceLevel().set_level_cell(row, column, AIR);
-            }
+    // Everyone starts awake, as if the window covered the whole level
+    dormant_chunks.assign(std::max<size_t>((level.get_columns() + CHUNK_COLUMNS - 1) / CHUNK_COLUMNS, 1), {});
+    dormant_count = 0;
+    max_patrol_chunks = 0;
+    window_first_chunk = 0;
+    window_last_chunk = static_cast<long>(dormant_chunks.size()) - 1;
+    simulated_frames = 0;
+    flow_field.reset(level.get_rows(), level.get_columns());
+
+    spawn_enemies_in(0, level.get_columns() - 1);
+}
+
+void EnemiesController::spawn_enemies_in(size_t first_column, size_t last_column) {
+    const Level &level = LevelController::getInstanceLevel().get_current_level();
+    last_span = {};
+    level.get_bitplanes().for_each<SPAWN_TRAIT>(0, level.get_rows() - 1, first_column, last_column, [&](size_t row, size_t column, uint8_t kind) {
+        if (kind == CHASER_TILE) {
+            const Vector2 pos = {static_cast<float>(column), static_cast<float>(row)};
+            chaser_grid.insert(chasers.push_back({pos}, {pos}, {ENEMY_WALK_CLIP, animation_phase(static_cast<uint32_t>(row << 16 | column)), 0}), pos.x);
+            LevelController::getInstanceLevel().set_level_cell(row, column, AIR);
+            return;
+        }
+        if (kind != ENEMY_TILE) return;
+
+        // Instantiate and add an enemy to the level
+        add_enemy({static_cast<int32_t>(column) * ENEMY_SUBCELLS, 1, 0, 0, static_cast<float>(row)});
+        LevelController::getInstanceLevel().set_level_cell(row, column, AIR);
+    });
+
+    reserve_for_play();
+}
+
+void EnemiesController::reserve(const size_t enemy_count) {
+    enemies.reserve(enemy_count);
+    grid.reserve(enemy_count);
+    chasers.reserve(enemy_count);
+    chaser_grid.reserve(enemy_count);
+    step_scratch.reserve(enemy_count);
+    removal_scratch.reserve(enemy_count);
+    shift_scratch.reserve(enemy_count);
+
+    // And an enemy per column in every sleeper bucket
+    for (std::vector<DormantEnemy> &sleepers : dormant_chunks) {
+        sleepers.reserve(std::min<size_t>(enemy_count, CHUNK_COLUMNS));
+    }
+}
+
+void EnemiesController::save(snapshot &out) const {
+    out.enemies = enemies;
+    out.grid = grid;
+    out.dormant_chunks = dormant_chunks;
+    out.dormant_count = dormant_count;
+    out.max_patrol_chunks = max_patrol_chunks;
+    out.window_first_chunk = window_first_chunk;
+    out.window_last_chunk = window_last_chunk;
+    out.simulated_frames = simulated_frames;
+    out.flow_field = flow_field;
+    out.chasers = chasers;
+    out.chaser_grid = chaser_grid;
+}
+
+void EnemiesController::restore(const snapshot &in) {
+    enemies = in.enemies;
+    grid = in.grid;
+    dormant_chunks = in.dormant_chunks;
+    dormant_count = in.dormant_count;
+    max_patrol_chunks = in.max_patrol_chunks;
+    window_first_chunk = in.window_first_chunk;
+    window_last_chunk = in.window_last_chunk;
+    simulated_frames = in.simulated_frames;
+    flow_field = in.flow_field;
+    chasers = in.chasers;
+    chaser_grid = in.chaser_grid;
+
+    // The snapshot may be from before enemies were removed, so there can be more of them again
+    reserve_for_play();
+}
+
+void EnemiesController::reserve_for_play() {
+    // The scratch buffers never need to hold more than every enemy at once
+    const size_t total = get_enemy_count();
+    step_scratch.reserve(total);
+    removal_scratch.reserve(total);
+    shift_scratch.reserve(total);
+
+    // Each enemy with a bounded patrol sleeps in the bucket of the chunk its patrol starts in
+    sleeper_count_scratch.assign(dormant_chunks.size(), 0);
+    for (size_t i = 0; i < enemies.size(); ++i) {
+        const EnemyState enemy = enemies.get(i);
+        if (enemy.patrol_lo == UNBOUNDED_PATROL_LO || enemy.patrol_hi == UNBOUNDED_PATROL_HI) continue;
+        ++sleeper_count_scratch[first_patrol_chunk(enemy)];
+    }
+    for (size_t chunk = 0; chunk < dormant_chunks.size(); ++chunk) {
+        // Grown geometrically like push_back would, so the buckets of an endless level settle on a size
+        std::vector<DormantEnemy> &sleepers = dormant_chunks[chunk];
+        const size_t needed = sleepers.size() + sleeper_count_scratch[chunk];
+        if (needed > sleepers.capacity()) sleepers.reserve(std::max(needed, sleepers.capacity() * 2));
+    }
+}
+
+void EnemiesController::add_enemy(EnemyState enemy) {
+    const TileBitplanes &bitplanes = LevelController::getInstanceLevel().get_current_level().get_bitplanes();
+    const DynamicColliders &dynamic = LevelController::getInstanceLevel().get_dynamic_colliders();
+    const long column_count = static_cast<long>(LevelController::getInstanceLevel().get_current_level().get_columns());
+    const long column = floor_div(enemy.position, ENEMY_SUBCELLS);
+
+    // Find the walls the enemy is going to pace between
+    if (enemy.y != last_span.y || column <= last_span.left_wall || column >= last_span.right_wall) {
+        long left_wall = column - 1;
+        while (left_wall >= 0 && !bitplanes.is_solid_column(left_wall, enemy.y)) --left_wall;
+        long right_wall = column + 1;
+        while (right_wall < column_count && !bitplanes.is_solid_column(right_wall, enemy.y)) ++right_wall;
+
+        bool reachable = false;
+        for (long patrol_column = left_wall + 1; patrol_column < right_wall && !reachable; ++patrol_column) {
+            reachable = dynamic.may_reach(patrol_column);
+        }
+        last_span = {enemy.y, left_wall, right_wall, reachable};
+    }
+
+    enemy.patrol_lo = last_span.left_wall >= 0 ? static_cast<int32_t>(last_span.left_wall + 1) * ENEMY_SUBCELLS : UNBOUNDED_PATROL_LO;
+    enemy.patrol_hi = last_span.right_wall < column_count ? static_cast<int32_t>(last_span.right_wall - 1) * ENEMY_SUBCELLS : UNBOUNDED_PATROL_HI;
+
+    // A moving collider can cut a patrol short at any time, so those enemies are never fast-forwarded
+    if (last_span.reachable) {
+        enemy.patrol_lo = UNBOUNDED_PATROL_LO;
+        enemy.patrol_hi = UNBOUNDED_PATROL_HI;
+    }
+    if (enemy.patrol_lo != UNBOUNDED_PATROL_LO && enemy.patrol_hi != UNBOUNDED_PATROL_HI) {
+        max_patrol_chunks = std::max(max_patrol_chunks, last_patrol_chunk(enemy) - first_patrol_chunk(enemy));
+    }
+    enemies.push_back(enemy);
+    grid.insert(static_cast<uint32_t>(enemies.size() - 1), enemies.get_pos(enemies.size() - 1).x);
+}
+
+void EnemiesController::shift_origin(const long columns) {
+    // Wake the sleepers first, so they are where they would be by now
+    for (std::vector<DormantEnemy> &sleepers : dormant_chunks) {
+        for (DormantEnemy &sleeper : sleepers) {
+            wake_up(sleeper);
+        }
+        sleepers.clear();
+    }
+
+    // Re-add everyone still in the level at the new origin. Their walls are searched again,
+    // as the columns that just came in may close a patrol that used to run off the edge.
+    shift_scratch.clear();
+    for (size_t i = 0; i < enemies.size(); ++i) {
+        shift_scratch.push_back(enemies.get(i));
+    }
+    enemies.clear();
+    grid.reset(LevelController::getInstanceLevel().get_current_level().get_columns());
+    max_patrol_chunks = 0;
+    last_span = {};
+    for (EnemyState enemy : shift_scratch) {
+        enemy.position -= static_cast<int32_t>(columns) * ENEMY_SUBCELLS;
+        if (enemy.position < 0) continue;
+        add_enemy(enemy);
+    }
+
+    // Everyone is awake again; the next update puts the far ones back to sleep
+    window_first_chunk = 0;
+    window_last_chunk = static_cast<long>(dormant_chunks.size()) - 1;
+
+    chasers.for_each<Position, PathTarget>([columns](Position &position, PathTarget &target) {
+        position.value.x -= static_cast<float>(columns);
+        target.value.x -= static_cast<float>(columns);
+    });
+    for (size_t i = chasers.size(); i-- > 0;) {
+        if (chasers.get<Position>(i).value.x < 0.0f) chasers.swap_remove(i);
+    }
+    const Level &level = LevelController::getInstanceLevel().get_current_level();
+    flow_field.reset(level.get_rows(), level.get_columns());
+    chaser_grid.reset(level.get_columns());
+    for (size_t i = 0; i < chasers.size(); ++i) {
+        chaser_grid.insert(static_cast<uint32_t>(i), chasers.get<Position>(i).value.x);
+    }
+}
+
+long EnemiesController::first_patrol_chunk(const EnemyState &enemy) {
+    return enemy.patrol_lo / ENEMY_SUBCELLS / CHUNK_COLUMNS;
+}
+
+long EnemiesController::last_patrol_chunk(const EnemyState &enemy) {
+    return (enemy.patrol_hi + ENEMY_SUBCELLS - 1) / ENEMY_SUBCELLS / CHUNK_COLUMNS;
+}
+
+void EnemiesController::put_to_sleep(const uint32_t index) {
+    const EnemyState enemy = enemies.get(index);
+    dormant_chunks[first_patrol_chunk(enemy)].push_back({enemy, simulated_frames});
+    ++dormant_count;
+    remove_enemy(index);
+}
+
+void EnemiesController::wake_up(DormantEnemy &dormant) {
+    // Put the enemy where it would be had it been simulated all along
+    EnemyState enemy = dormant.state;
+    advance_patrol(enemy, simulated_frames - dormant.since_frame);
+    enemies.push_back(enemy);
+    grid.insert(static_cast<uint32_t>(enemies.size() - 1), enemies.get_pos(enemies.size() - 1).x);
+    --dormant_count;
+}
+
+void EnemiesController::update_simulation_window() {
+    // Everything a screen can show around any of the players, plus the margin, in whole chunks
+    float leftmost_x = std::numeric_limits<float>::infinity();
+    float rightmost_x = -std::numeric_limits<float>::infinity();
+    Player::getInstancePlayer().get_players().for_each<Position>([&](const Position &position) {
+        leftmost_x = std::min(leftmost_x, position.value.x);
+        rightmost_x = std::max(rightmost_x, position.value.x);
+    });
+    const float rows = static_cast<float>(LevelController::getInstanceLevel().get_current_level().get_rows());
+    const float half_view = rows * SIMULATION_VIEW_ASPECT / 2.0f + 1.0f;
+    const float chunk_limit = static_cast<float>(dormant_chunks.size() - 1);
+    const long first = static_cast<long>(std::clamp((leftmost_x - half_view - enemy_simulation_margin) / CHUNK_COLUMNS, 0.0f, chunk_limit));
+    const long last = static_cast<long>(std::clamp((rightmost_x + half_view + enemy_simulation_margin) / CHUNK_COLUMNS, 0.0f, chunk_limit));
+
+    // Nothing can enter or leave while the window stays within the same chunks
+    if (first == window_first_chunk && last == window_last_chunk) return;
+    window_first_chunk = first;
+    window_last_chunk = last;
+
+    // Put the enemies whose whole patrol is outside the window to sleep
+    for (size_t i = enemies.size(); i-- > 0;) {
+        const EnemyState enemy = enemies.get(i);
+        if (enemy.patrol_lo == UNBOUNDED_PATROL_LO || enemy.patrol_hi == UNBOUNDED_PATROL_HI) continue;
+        if (last_patrol_chunk(enemy) < first || first_patrol_chunk(enemy) > last) {
+            put_to_sleep(static_cast<uint32_t>(i));
+        }
+    }
+
+    // Wake the sleepers whose patrol reaches into the window; none starts more than max_patrol_chunks before it
+    for (long chunk = std::max(first - max_patrol_chunks, 0L); chunk <= last; ++chunk) {
+        std::vector<DormantEnemy> &sleepers = dormant_chunks[chunk];
+        for (size_t i = sleepers.size(); i-- > 0;) {
+            if (last_patrol_chunk(sleepers[i].state) < first) continue;
+            wake_up(sleepers[i]);
+            sleepers[i] = sleepers.back();
+            sleepers.pop_back();
         }
     }
 }
 
 void EnemiesController::update_enemies() {
-    for (auto &enemy : enemies) {
-        // Find the enemy's next x
-        float next_x = enemy.get_pos().x;
-        next_x += (enemy.is_looking_right() ? ENEMY_MOVEMENT_SPEED : -ENEMY_MOVEMENT_SPEED);
-
-        // If its next position collides with a wall, turn around
-        if (LevelController::getInstanceLevel().is_colliding({next_x, enemy.get_pos().y}, WALL)) {
-            enemy.set_looking_right(!enemy.is_looking_right());
+    TRACE_ZONE("update_enemies");
+
+    update_simulation_window();
+
+    const TileBitplanes &bitplanes = LevelController::getInstanceLevel().get_current_level().get_bitplanes();
+    const DynamicColliders &dynamic = LevelController::getInstanceLevel().get_dynamic_colliders();
+    const size_t count = enemies.size();
+    current_frame_counters.active_enemies = count + chasers.size();
+    int32_t *positions = enemies.get_positions();
+    int32_t *directions = enemies.get_directions();
+    float *xs = enemies.get_xs();
+    const float *ys = enemies.get_ys();
+
+    // Find every enemy's next position
+    step_scratch.resize(count);
+    int32_t *next_positions = step_scratch.data();
+    for (size_t i = 0; i < count; ++i) {
+        next_positions[i] = positions[i] + directions[i] * ENEMY_MOVEMENT_STEP;
+    }
+
+    // If its next position collides with a wall, turn around; otherwise, keep moving.
+    // Only the column the leading edge steps into can be new, the same tiles a sweep would test.
+    // Written as selects rather than branches so the loop has no data-dependent jumps.
+    for (size_t i = 0; i < count; ++i) {
+        const int32_t leading_edge = next_positions[i] + (directions[i] > 0) * (ENEMY_SUBCELLS - 1);
+        const int32_t blocked = bitplanes.is_solid_column(floor_div(leading_edge, ENEMY_SUBCELLS), ys[i]);
+        next_positions[i] += blocked * (positions[i] - next_positions[i]);
+        directions[i] *= 1 - 2 * blocked;
+    }
+
+    // Moving solids are rare, so only the enemies stepping into a column one can reach take the full query.
+    // Like a sweep, a collider the enemy already overlaps does not stop it.
+    for (size_t i = 0; i < count && !dynamic.empty(); ++i) {
+        if (next_positions[i] == positions[i]) continue;
+        const long column = floor_div(next_positions[i], ENEMY_SUBCELLS);
+        if (!dynamic.may_reach(column) && !dynamic.may_reach(column + 1)) continue;
+
+        const Vector2 next = {static_cast<float>(next_positions[i]) / ENEMY_SUBCELLS, ys[i]};
+        if (dynamic.overlaps<SOLID_TRAIT>(next) && !dynamic.overlaps<SOLID_TRAIT>(enemies.get_pos(i))) {
+            next_positions[i] = positions[i];
+            directions[i] = -directions[i];
         }
-        // Otherwise, keep moving
-        else {
-            enemy.set_pos(Vector2{next_x, enemy.get_pos().y});
+    }
+
+    // Commit the moves, relinking the enemies that crossed into another column
+    for (size_t i = 0; i < count; ++i) {
+        const float next_x = static_cast<float>(next_positions[i]) / ENEMY_SUBCELLS;
+        if (static_cast<long>(next_x) != static_cast<long>(xs[i])) {
+            grid.move(static_cast<uint32_t>(i), next_x);
         }
+        positions[i] = next_positions[i];
+        xs[i] = next_x;
     }
+
+    ++simulated_frames;
+
+    update_chasers();
+}
+
+void EnemiesController::update_animations() {
+    step_animations(enemies.get_animations(), enemies.size());
+    step_animations(chasers.data<Animation>(), chasers.size());
+}
+
+void EnemiesController::invalidate_navigation(size_t row, size_t column) {
+    flow_field.invalidate(row, column);
+}
+
+void EnemiesController::update_chasers() {
+    if (chasers.empty()) return;
+
+    // The field is only rebuilt when the player enters another cell
+    const Vector2 player_pos = Player::getInstancePlayer().get_player_pos();
+    const Level &level = LevelController::getInstanceLevel().get_current_level();
+    const TileBitplanes &tiles = level.get_bitplanes();
+    flow_field.update(tiles, floor_to_long(player_pos.y + 0.5f), floor_to_long(player_pos.x + 0.5f));
+
+    auto approach = [](float value, float goal) {
+        float distance = goal - value;
+        if (std::fabs(distance) <= CHASER_MOVEMENT_SPEED) return goal;
+        return value + (distance > 0.0f ? CHASER_MOVEMENT_SPEED : -CHASER_MOVEMENT_SPEED);
+    };
+
+    uint32_t chaser = 0;
+    chasers.for_each<Position, PathTarget>([&](Position &position, PathTarget &path_target) {
+        const uint32_t index = chaser++;
+        Vector2 &pos = position.value;
+        Vector2 &target = path_target.value;
+
+        // On reaching a cell centre, the field says which neighbour is one step closer to the player.
+        // Moving between centres keeps the hitbox inside the two free cells, so no sweep is needed.
+        if (pos.x == target.x && pos.y == target.y) {
+            const long row = static_cast<long>(pos.y);
+            const long column = static_cast<long>(pos.x);
+            switch (flow_field.get_direction(row, column)) {
+                case FLOW_LEFT:  target.x -= 1.0f; break;
+                case FLOW_RIGHT: target.x += 1.0f; break;
+                case FLOW_UP:    target.y -= 1.0f; break;
+                case FLOW_DOWN:  target.y += 1.0f; break;
+                default: {
+                    // Too far for the field: walk along the row towards the player until it
+                    // covers the chaser, waiting at walls. Unreachable cells inside it stay put.
+                    if (flow_field.covers(column)) return;
+                    const long next = column + (player_pos.x > pos.x ? 1 : -1);
+                    if (next < 0 || next >= static_cast<long>(level.get_columns()) || tiles.is_solid_column(next, pos.y)) return;
+                    target.x = static_cast<float>(next);
+                    break;
+                }
+            }
+        }
+
+        pos.x = approach(pos.x, target.x);
+        pos.y = approach(pos.y, target.y);
+        chaser_grid.move(index, pos.x);
+    });
 }
 
 // Custom is_colliding function for enemies
 bool EnemiesController::is_colliding_with_enemies(const Vector2 pos) const {
+    ++current_frame_counters.collision_queries;
     Rectangle entity_hitbox = {pos.x, pos.y, 1.0f, 1.0f};
 
-    for (auto &enemy : enemies) {
-        const Rectangle enemy_hitbox = { enemy.get_pos().x, enemy.get_pos().y, 1.0f, 1.0f};
-        if (CheckCollisionRecs(entity_hitbox, enemy_hitbox)) {
-            return true;
-        }
+    // Only enemies in the columns next to the hitbox can touch it
+    bool colliding = false;
+    grid.for_each_in_range(pos.x - 1.0f, pos.x + 1.0f, [&](uint32_t i) {
+        const Rectangle enemy_hitbox = { enemies.get_pos(i).x, enemies.get_pos(i).y, 1.0f, 1.0f};
+        colliding = colliding || CheckCollisionRecs(entity_hitbox, enemy_hitbox);
+    });
+
+    chaser_grid.for_each_in_range(pos.x - 1.0f, pos.x + 1.0f, [&](uint32_t i) {
+        const Vector2 chaser = chasers.get<Position>(i).value;
+        colliding = colliding || CheckCollisionRecs(entity_hitbox, {chaser.x, chaser.y, 1.0f, 1.0f});
+    });
+    return colliding;
+}
+
+void EnemiesController::remove_enemy(uint32_t index) {
+    // Swap-and-pop: the last enemy takes the removed one's slot
+    uint32_t last = static_cast<uint32_t>(enemies.size()) - 1;
+    grid.remove(index);
+    if (index != last) {
+        grid.relabel(last, index);
+    }
+    enemies.swap_remove(index);
+}
+
+void EnemiesController::remove_chaser(uint32_t index) {
+    uint32_t last = static_cast<uint32_t>(chasers.size()) - 1;
+    chaser_grid.remove(index);
+    if (index != last) {
+        chaser_grid.relabel(last, index);
     }
-    return false;
+    chasers.swap_remove(index);
 }
 
 void EnemiesController::remove_colliding_enemy(const Vector2 pos) {
     const Rectangle entity_hitbox = {pos.x, pos.y, 1.0f, 1.0f};
 
-    for (auto it = enemies.begin(); it != enemies.end(); ++it) {
-        // Erase a colliding enemy
-        if (const Rectangle enemy_hitbox = {(float) it->get_pos().x, (float) it->get_pos().y, 1.0f, 1.0f}; CheckCollisionRecs(entity_hitbox, enemy_hitbox)) {
-            enemies.erase(it);
+    removal_scratch.clear();
+    grid.for_each_in_range(pos.x - 1.0f, pos.x + 1.0f, [&](uint32_t i) {
+        const Rectangle enemy_hitbox = { enemies.get_pos(i).x, enemies.get_pos(i).y, 1.0f, 1.0f};
+        if (CheckCollisionRecs(entity_hitbox, enemy_hitbox)) {
+            removal_scratch.push_back(i);
+        }
+    });
 
-            // Call the function again to remove any remaining colliding enemies
-            // Cannot continue as calling erase on a vector invalidates current iterators
-            remove_colliding_enemy(pos);
-            return;
+    // Remove from the back so swap-and-pop never moves an enemy that is still to be removed
+    std::sort(removal_scratch.begin(), removal_scratch.end(), std::greater<>());
+    for (uint32_t i : removal_scratch) {
+        remove_enemy(i);
+    }
+
+    removal_scratch.clear();
+    chaser_grid.for_each_in_range(pos.x - 1.0f, pos.x + 1.0f, [&](uint32_t i) {
+        const Vector2 chaser = chasers.get<Position>(i).value;
+        if (CheckCollisionRecs(entity_hitbox, {chaser.x, chaser.y, 1.0f, 1.0f})) {
+            removal_scratch.push_back(i);
         }
+    });
+    std::sort(removal_scratch.begin(), removal_scratch.end(), std::greater<>());
+    for (uint32_t i : removal_scratch) {
+        remove_chaser(i);
     }
 }
 
-    void EnemiesController::draw_enemies(){
-        // Go over all enemies and draw them, once again accounting to the player's movement and horizontal shift
-        for (auto &enemy : EnemiesController::getInstance().get_enemies()) {
-            horizontal_shift = (screen_size.x - cell_size) / 2;
+void EnemiesController::draw_enemies() {
+    // Go over the enemies on screen and draw them, once again accounting to the player's movement and horizontal shift
+    horizontal_shift = (screen_size.x - cell_size) / 2;
+
+    const EnemiesController &controller = EnemiesController::getInstance();
+    const float player_x = Player::getInstancePlayer().get_player_posX(local_player);
+    const float first_visible = player_x - (horizontal_shift + cell_size) / cell_size;
+    const float last_visible = player_x + (screen_size.x - horizontal_shift) / cell_size;
 
-            Vector2 pos = {
-                (enemy.get_pos().x - Player::getInstancePlayer().get_player_posX()) * cell_size + horizontal_shift,
-                enemy.get_pos().y * cell_size
+    controller.grid.for_each_in_range(first_visible, last_visible, [&](uint32_t i) {
+        const Vector2 enemy_pos = controller.enemies.get_pos(i);
+
+        Vector2 pos = {
+            (enemy_pos.x - player_x) * cell_size + horizontal_shift,
+            enemy_pos.y * cell_size
         };
 
-            draw_sprite(enemy_walk, pos, cell_size);
-        }
-    }
\ No newline at end of file
+        draw_animation(controller.enemies.get_animation(i), pos, cell_size);
+    });
+
+    controller.chaser_grid.for_each_in_range(first_visible, last_visible, [&](uint32_t i) {
+        const Vector2 chaser = controller.chasers.get<Position>(i).value;
+
+        Vector2 pos = {
+            (chaser.x - player_x) * cell_size + horizontal_shift,
+            chaser.y * cell_size
+        };
+
+        draw_animation(controller.chasers.get<Animation>(i), pos, cell_size);
+    });
+}
@@ -3,14 +3,30 @@
 #include <vector>
 #include <raylib.h>
 #include "enemy.h"
+#include "column_grid.h"
+#include "flow_field.h"
 #include "level.h"
+#include "archetype.h"
+#include "components.h"
+
+// Where a chaser is, the cell centre it is heading for and its walk cycle
+using ChaserArchetype = Archetype<Position, PathTarget, Animation>;
 
 class EnemiesController {
 public:
-    [[nodiscard]] std::vector<Enemy> get_enemies() const {
+    // Only the enemies near the screen; the rest are asleep until the camera comes close
+    [[nodiscard]] const EnemyStore& get_enemies() const {
         return enemies;
     }
 
+    [[nodiscard]] size_t get_enemy_count() const {
+        return enemies.size() + dormant_count + chasers.size();
+    }
+
+    [[nodiscard]] const FlowField& get_flow_field() const {
+        return flow_field;
+    }
+
     static EnemiesController &getInstance() {
         static EnemiesController instance;
         return instance;
@@ -22,17 +38,94 @@ public:
     EnemiesController operator=(EnemiesController&&) = delete;
 
     void spawn_enemies();
+    // Spawns the enemies marked in the given columns only, for chunks streamed into an endless level
+    void spawn_enemies_in(size_t first_column, size_t last_column);
+    // The level scrolled left by the given number of columns; enemies move along with it
+    // and those that scrolled off are dropped
+    void shift_origin(long columns);
+    // Makes room for this many enemies at once, so streaming them in during play does not allocate
+    void reserve(size_t enemy_count);
     void update_enemies();
+    // Steps the walk cycles of the enemies that are awake
+    void update_animations();
     bool is_colliding_with_enemies(Vector2 pos) const;
     void remove_colliding_enemy(Vector2 pos);
+    void remove_enemy(uint32_t index);
+    void invalidate_navigation(size_t row_index, size_t column_index);
 
     static void draw_enemies();
 
+    struct DormantEnemy {
+        EnemyState state;
+        uint64_t since_frame; // simulated_frames when the enemy fell asleep
+    };
+
+    // Everything update_enemies reads or writes, for rollback. Saving into the same snapshot
+    // again reuses its buffers, so a warmed up snapshot is a plain copy.
+    struct snapshot {
+        EnemyStore enemies;
+        ColumnGrid grid;
+        std::vector<std::vector<DormantEnemy>> dormant_chunks;
+        size_t dormant_count;
+        long max_patrol_chunks;
+        long window_first_chunk;
+        long window_last_chunk;
+        uint64_t simulated_frames;
+        FlowField flow_field;
+        ChaserArchetype chasers;
+        ColumnGrid chaser_grid;
+    };
+
+    void save(snapshot &out) const;
+    void restore(const snapshot &in);
+
 private:
     EnemiesController() = default;
     ~EnemiesController() = default;
 
-    std::vector<Enemy> enemies{};
+    // Sleeping enemies are bucketed by the chunk their patrol starts in
+    static constexpr long CHUNK_COLUMNS = 16;
+
+    void add_enemy(EnemyState enemy);
+    // Sizes every buffer the updates fill for the enemies spawned so far, so play itself never allocates
+    void reserve_for_play();
+    void update_simulation_window();
+    void update_chasers();
+    void remove_chaser(uint32_t index);
+    void put_to_sleep(uint32_t index);
+    void wake_up(DormantEnemy &enemy);
+    [[nodiscard]] static long first_patrol_chunk(const EnemyState &enemy);
+    [[nodiscard]] static long last_patrol_chunk(const EnemyState &enemy);
+
+    EnemyStore enemies{};
+    ColumnGrid grid;
+    std::vector<uint32_t> removal_scratch;
+    std::vector<int32_t> step_scratch;
+    std::vector<EnemyState> shift_scratch;
+    std::vector<size_t> sleeper_count_scratch;
+
+    // The walls add_enemy found last. Enemies are added row by row, so the next one often paces
+    // the same stretch and skips the search, which on a long open row crosses the whole level.
+    struct patrol_span {
+        float y;
+        long left_wall;
+        long right_wall;
+        bool reachable; // By a moving collider
+    };
+    patrol_span last_span{};
+
+    std::vector<std::vector<DormantEnemy>> dormant_chunks;
+    size_t dormant_count = 0;
+    long max_patrol_chunks = 0;
+    long window_first_chunk = 0;
+    long window_last_chunk = 0;
+    uint64_t simulated_frames = 0;
+
+    // Chasers follow a flow field towards the player, one cell centre at a time, and have a
+    // broadphase of their own so the player's queries skip the patrol enemies' one
+    FlowField flow_field;
+    ChaserArchetype chasers;
+    ColumnGrid chaser_grid;
 };
 
 #endif //ENEMIES_CONTROLLER_H
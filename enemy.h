@@ -1,30 +1,146 @@
 #ifndef ENEMY_H
 #define ENEMY_H
 
-class Enemy {
+#include "raylib.h"
+#include "components.h"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// Enemies walk on a fixed-point grid of this many subcells per tile, so a patrol between two
+// walls repeats exactly and can be fast-forwarded without replaying every frame
+inline const int32_t ENEMY_SUBCELLS = 100;
+
+// Patrol bound of an enemy with no wall on that side, which keeps it fully simulated
+inline const int32_t UNBOUNDED_PATROL_LO = std::numeric_limits<int32_t>::min();
+inline const int32_t UNBOUNDED_PATROL_HI = std::numeric_limits<int32_t>::max();
+
+// The state of one enemy, used when it moves in or out of the store
+struct EnemyState {
+    int32_t position;  // x in subcells
+    int32_t direction; // +1 when looking right, -1 when looking left
+    int32_t patrol_lo; // Furthest left and right positions between the enemy's walls
+    int32_t patrol_hi;
+    float y;
+};
+
+// All enemies of a level, kept as parallel arrays so the per-frame update
+// streams through contiguous values instead of hopping between objects
+class EnemyStore {
 public:
-    Enemy(const Vector2 &pos, const bool looking_right)
-        : pos{pos}, looking_right{looking_right} { }
+    [[nodiscard]] size_t size() const {
+        return positions.size();
+    }
+
+    [[nodiscard]] bool empty() const {
+        return positions.empty();
+    }
+
+    void clear() {
+        positions.clear();
+        directions.clear();
+        patrol_los.clear();
+        patrol_his.clear();
+        xs.clear();
+        ys.clear();
+        animations.clear();
+    }
+
+    void reserve(const size_t count) {
+        positions.reserve(count);
+        directions.reserve(count);
+        patrol_los.reserve(count);
+        patrol_his.reserve(count);
+        xs.reserve(count);
+        ys.reserve(count);
+        animations.reserve(count);
+    }
+
+    void push_back(const EnemyState &enemy) {
+        positions.push_back(enemy.position);
+        directions.push_back(enemy.direction);
+        patrol_los.push_back(enemy.patrol_lo);
+        patrol_his.push_back(enemy.patrol_hi);
+        xs.push_back(static_cast<float>(enemy.position) / ENEMY_SUBCELLS);
+        ys.push_back(enemy.y);
+
+        // Where the enemy came in picks its step of the walk cycle
+        const uint32_t seed = static_cast<uint32_t>(enemy.position) ^ static_cast<uint32_t>(enemy.y) << 16;
+        animations.push_back({ENEMY_WALK_CLIP, animation_phase(seed), 0});
+    }
+
+    [[nodiscard]] EnemyState get(const size_t index) const {
+        return {positions[index], directions[index], patrol_los[index], patrol_his[index], ys[index]};
+    }
+
+    // Moves the last enemy into the removed one's slot
+    void swap_remove(const size_t index) {
+        positions[index] = positions.back();
+        directions[index] = directions.back();
+        patrol_los[index] = patrol_los.back();
+        patrol_his[index] = patrol_his.back();
+        xs[index] = xs.back();
+        ys[index] = ys.back();
+        animations[index] = animations.back();
+        positions.pop_back();
+        directions.pop_back();
+        patrol_los.pop_back();
+        patrol_his.pop_back();
+        xs.pop_back();
+        ys.pop_back();
+        animations.pop_back();
+    }
+
+    [[nodiscard]] Vector2 get_pos(const size_t index) const {
+        return {xs[index], ys[index]};
+    }
+
+    [[nodiscard]] bool is_looking_right(const size_t index) const {
+        return directions[index] > 0;
+    }
+
+    [[nodiscard]] const Animation& get_animation(const size_t index) const {
+        return animations[index];
+    }
+
+    [[nodiscard]] int32_t get_patrol_lo(const size_t index) const {
+        return patrol_los[index];
+    }
+
+    [[nodiscard]] int32_t get_patrol_hi(const size_t index) const {
+        return patrol_his[index];
+    }
+
+    // Raw arrays for the batched update kernels
+    [[nodiscard]] int32_t* get_positions() {
+        return positions.data();
+    }
 
-    void set_pos(const Vector2 &pos) {
-        this->pos = pos;
+    [[nodiscard]] int32_t* get_directions() {
+        return directions.data();
     }
 
-    void set_looking_right(const bool looking_right) {
-        this->looking_right = looking_right;
+    [[nodiscard]] float* get_xs() {
+        return xs.data();
     }
 
-    [[nodiscard]] Vector2 get_pos() const {
-        return pos;
+    [[nodiscard]] const float* get_ys() const {
+        return ys.data();
     }
 
-    [[nodiscard]] bool is_looking_right() const {
-        return looking_right;
+    [[nodiscard]] Animation* get_animations() {
+        return animations.data();
     }
 
 private:
-    Vector2 pos;
-    bool looking_right;
+    std::vector<int32_t> positions;
+    std::vector<int32_t> directions;
+    std::vector<int32_t> patrol_los;
+    std::vector<int32_t> patrol_his;
+    std::vector<float> xs; // positions in tiles, for drawing and collisions
+    std::vector<float> ys;
+    std::vector<Animation> animations; // Not part of EnemyState, a woken enemy picks a new phase
 };
 
-#endif //ENEMY_H
\ No newline at end of file
+#endif //ENEMY_H
@@ -0,0 +1,56 @@
+#include "file_watcher.h"
+#include <filesystem>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher(const std::string &path)
+    : file_name(std::filesystem::path(path).filename().string()) {
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    if (directory.empty()) directory = ".";
+
+    inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) throw std::runtime_error("Could not start watching files");
+    if (::inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        ::close(inotify_fd);
+        throw std::runtime_error("Could not watch " + directory);
+    }
+}
+
+FileWatcher::~FileWatcher() {
+    if (inotify_fd >= 0) ::close(inotify_fd);
+}
+
+bool FileWatcher::poll() {
+    // Every event waiting is read, so a save that touched the file twice counts once
+    bool written = false;
+    alignas(inotify_event) char buffer[4096];
+    ssize_t size;
+    while ((size = ::read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t offset = 0; offset < size;) {
+            const auto *event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0 && file_name == event->name) written = true;
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+    }
+    return written;
+}
+
+#else
+
+FileWatcher::FileWatcher(const std::string&) {
+    throw std::runtime_error("Watching files is only supported on Linux");
+}
+
+FileWatcher::~FileWatcher() = default;
+
+bool FileWatcher::poll() {
+    return false;
+}
+
+#endif
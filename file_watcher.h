@@ -0,0 +1,25 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <string>
+
+// Tells when a file was written. The file's directory is watched with inotify rather than the file
+// itself, so editors that save by renaming a new file over the old one are noticed too.
+// Throws std::runtime_error when the watch cannot be set up; only Linux is supported.
+class FileWatcher {
+public:
+    explicit FileWatcher(const std::string &path);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Whether the file was written since the last call; never waits
+    [[nodiscard]] bool poll();
+
+private:
+    int inotify_fd = -1;
+    std::string file_name;
+};
+
+#endif // FILE_WATCHER_H
@@ -0,0 +1,143 @@
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include "tile_bitplanes.h"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+enum flow_direction : uint8_t {
+    NO_FLOW,
+    FLOW_LEFT,
+    FLOW_RIGHT,
+    FLOW_UP,
+    FLOW_DOWN
+};
+
+// Breadth-first distances to a target cell over every non-solid cell within RADIUS columns
+// of it, shared by all chasing enemies. Each cell stores the step towards its neighbour one
+// closer to the target, so following the field is a single lookup per enemy. The field is
+// only rebuilt when the target moves to another cell or a tile inside it changes solidity.
+class FlowField {
+public:
+    static constexpr long RADIUS = 24;
+    static constexpr uint16_t UNREACHABLE = 0xFFFF;
+
+    void reset(size_t row_count, size_t column_count);
+
+    // A tile changed solidity; the field is rebuilt on the next update if it lies inside
+    void invalidate(size_t row_index, size_t column_index);
+
+    // Returns whether the field had to be rebuilt
+    bool update(const TileBitplanes &tiles, long target_row, long target_column);
+
+    [[nodiscard]] flow_direction get_direction(long row_index, long column_index) const;
+    // Whether the column lies within RADIUS columns of the target; cells outside have no flow
+    [[nodiscard]] bool covers(long column_index) const;
+    [[nodiscard]] uint16_t get_distance(long row_index, long column_index) const;
+
+private:
+    [[nodiscard]] bool contains(long row_index, long column_index) const;
+    [[nodiscard]] size_t index_of(long row_index, long column_index) const;
+
+    size_t rows = 0;
+    size_t columns = 0;
+    long first_column = 0;
+    long target_row = -1;
+    long target_column = -1;
+    bool dirty = true;
+
+    // Cells of the window around the target, row-major
+    std::vector<uint16_t> distances;
+    std::vector<uint8_t> directions;
+    std::vector<uint32_t> queue;
+};
+
+// --- Inline Definitions ---
+
+inline void FlowField::reset(size_t row_count, size_t column_count) {
+    rows = row_count;
+    columns = column_count;
+    target_row = -1;
+    target_column = -1;
+    dirty = true;
+
+    const size_t width = 2 * RADIUS + 1;
+    distances.assign(rows * width, UNREACHABLE);
+    directions.assign(rows * width, NO_FLOW);
+    queue.reserve(rows * width);
+}
+
+inline bool FlowField::contains(long row, long column) const {
+    return target_row >= 0 && row >= 0 && row < static_cast<long>(rows) &&
+           column >= first_column && column <= first_column + 2 * RADIUS;
+}
+
+inline size_t FlowField::index_of(long row, long column) const {
+    return static_cast<size_t>(row) * (2 * RADIUS + 1) + static_cast<size_t>(column - first_column);
+}
+
+inline void FlowField::invalidate(size_t row, size_t column) {
+    if (contains(static_cast<long>(row), static_cast<long>(column))) dirty = true;
+}
+
+inline bool FlowField::update(const TileBitplanes &tiles, long row, long column) {
+    if (!dirty && row == target_row && column == target_column) return false;
+    dirty = false;
+    target_row = row;
+    target_column = column;
+    first_column = column - RADIUS;
+
+    std::fill(distances.begin(), distances.end(), UNREACHABLE);
+    std::fill(directions.begin(), directions.end(), NO_FLOW);
+    if (row < 0 || row >= static_cast<long>(rows) || column < 0 || column >= static_cast<long>(columns) ||
+        tiles.is_solid_column(column, static_cast<float>(row))) {
+        return true;
+    }
+
+    // Each neighbour found points back at the cell it was reached from
+    static constexpr long ROW_STEPS[] = {0, 0, -1, 1};
+    static constexpr long COLUMN_STEPS[] = {-1, 1, 0, 0};
+    static constexpr flow_direction BACK[] = {FLOW_RIGHT, FLOW_LEFT, FLOW_DOWN, FLOW_UP};
+
+    queue.clear();
+    distances[index_of(row, column)] = 0;
+    queue.push_back(static_cast<uint32_t>(index_of(row, column)));
+    const long width = 2 * RADIUS + 1;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const long cell_row = queue[head] / width;
+        const long cell_column = queue[head] % width + first_column;
+        const uint16_t next_distance = distances[queue[head]] + 1;
+
+        for (int step = 0; step < 4; ++step) {
+            const long next_row = cell_row + ROW_STEPS[step];
+            const long next_column = cell_column + COLUMN_STEPS[step];
+            if (!contains(next_row, next_column) || next_column < 0 || next_column >= static_cast<long>(columns)) continue;
+
+            const size_t next = index_of(next_row, next_column);
+            if (distances[next] != UNREACHABLE || tiles.is_solid_column(next_column, static_cast<float>(next_row))) continue;
+
+            distances[next] = next_distance;
+            directions[next] = BACK[step];
+            queue.push_back(static_cast<uint32_t>(next));
+        }
+    }
+    return true;
+}
+
+inline flow_direction FlowField::get_direction(long row, long column) const {
+    if (!contains(row, column)) return NO_FLOW;
+    return static_cast<flow_direction>(directions[index_of(row, column)]);
+}
+
+inline bool FlowField::covers(long column) const {
+    return target_row >= 0 && column >= first_column && column <= first_column + 2 * RADIUS;
+}
+
+inline uint16_t FlowField::get_distance(long row, long column) const {
+    if (!contains(row, column)) return UNREACHABLE;
+    return distances[index_of(row, column)];
+}
+
+#endif // FLOW_FIELD_H
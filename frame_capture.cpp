@@ -0,0 +1,119 @@
+#include "frame_capture.h"
+#include "trace.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+FrameCapture::~FrameCapture() {
+    stop();
+}
+
+void FrameCapture::start(const std::string &new_directory, uint64_t new_interval) {
+    stop();
+
+    std::error_code error;
+    std::filesystem::create_directories(new_directory, error);
+    if (error) throw std::runtime_error("Could not create directory: " + new_directory);
+
+    directory = new_directory;
+    interval = new_interval > 0 ? new_interval : 1;
+    frame = 0;
+
+    // Sized in pixels, which is more than the window's size on high-DPI screens
+    for (size_t target = 0; target < targets.size(); ++target) {
+        targets[target] = LoadRenderTexture(GetRenderWidth(), GetRenderHeight());
+        pending[target] = false;
+    }
+    capturing = true;
+
+    stopping.store(false);
+    encoder = std::thread(&FrameCapture::run, this);
+}
+
+void FrameCapture::stop() {
+    if (!capturing) return;
+
+    // The newest capture is still waiting for its readback
+    for (size_t target = 0; target < targets.size(); ++target) {
+        if (pending[target]) read_back(target);
+    }
+    stopping.store(true);
+    encoder.join();
+
+    for (RenderTexture2D &target : targets) {
+        UnloadRenderTexture(target);
+        target = {};
+    }
+    capturing = false;
+}
+
+bool FrameCapture::is_capturing() const {
+    return capturing;
+}
+
+void FrameCapture::begin_frame() {
+    if (!capturing) return;
+    BeginTextureMode(targets[frame % 2]);
+}
+
+void FrameCapture::end_frame() {
+    if (!capturing) return;
+    const size_t current = frame % 2;
+    EndTextureMode();
+
+    // Render targets are stored upside down
+    const Texture2D &texture = targets[current].texture;
+    DrawTextureRec(texture, {0.0f, 0.0f, static_cast<float>(texture.width), -static_cast<float>(texture.height)},
+                   {0.0f, 0.0f}, WHITE);
+
+    // The previous frame is done by now
+    const size_t previous = 1 - current;
+    if (pending[previous]) read_back(previous);
+
+    pending[current] = frame % interval == 0;
+    pending_frame[current] = frame;
+    ++frame;
+}
+
+void FrameCapture::read_back(size_t target) {
+    TRACE_ZONE("capture read_back");
+    pending[target] = false;
+
+    Image image = LoadImageFromTexture(targets[target].texture);
+    ImageFlipVertical(&image);
+
+    // Only waits when the encoder has fallen a whole queue behind, as skipping frames would break the comparison
+    const captured_frame captured = {image, pending_frame[target]};
+    while (!encode_queue.push(captured)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void FrameCapture::write_png(const captured_frame &captured) const {
+    TRACE_ZONE("encode png");
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%06llu.png", static_cast<unsigned long long>(captured.frame));
+    const std::string path = directory + "/" + name;
+    if (!ExportImage(captured.image, path.c_str())) {
+        TraceLog(LOG_WARNING, "CAPTURE: Could not write %s", path.c_str());
+    }
+    UnloadImage(captured.image);
+}
+
+void FrameCapture::run() {
+    TRACE_THREAD_NAME("frame capture");
+
+    for (;;) {
+        // Checked before draining, so every frame queued before stop() is still written
+        const bool last_pass = stopping.load();
+
+        captured_frame captured{};
+        while (encode_queue.pop(captured)) {
+            write_png(captured);
+        }
+        if (last_pass) return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
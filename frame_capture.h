@@ -0,0 +1,63 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include "raylib.h"
+#include "spsc_queue.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// Saves every nth frame as a PNG, e.g. to compare replayed runs against golden images.
+// While capturing, frames are drawn into one of two render targets and then copied to the
+// screen. A captured frame is only read back at the end of the next frame, from the target
+// the GPU finished with meanwhile, so the readback does not wait on the frame being drawn.
+// The PNGs are encoded and written on a worker thread.
+class FrameCapture {
+public:
+    static constexpr size_t ENCODE_QUEUE_CAPACITY = 8;
+
+    FrameCapture() = default;
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // Captures frames 0, interval, 2 * interval... into directory, which is created if needed
+    void start(const std::string &directory, uint64_t interval);
+    // Writes out the frames still pending and waits for the encoder
+    void stop();
+
+    [[nodiscard]] bool is_capturing() const;
+
+    // Around the drawing of each frame, inside BeginDrawing/EndDrawing
+    void begin_frame();
+    void end_frame();
+
+private:
+    struct captured_frame {
+        Image image;
+        uint64_t frame;
+    };
+
+    void read_back(size_t target);
+    void write_png(const captured_frame &captured) const;
+    void run();
+
+    std::string directory;
+    uint64_t interval = 1;
+    uint64_t frame = 0;
+
+    std::array<RenderTexture2D, 2> targets{};
+    std::array<bool, 2> pending{};          // Holds a frame due for capture that was not read back yet
+    std::array<uint64_t, 2> pending_frame{};
+    bool capturing = false;
+
+    SpscQueue<captured_frame, ENCODE_QUEUE_CAPACITY> encode_queue;
+    std::atomic<bool> stopping{false};
+    std::thread encoder;
+};
+
+#endif // FRAME_CAPTURE_H
@@ -0,0 +1,304 @@
+#ifndef FRAME_TELEMETRY_H
+#define FRAME_TELEMETRY_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Phases of a frame in the order the main loop goes through them. Raylib polls input at the
+// end of EndDrawing, so INPUT_PHASE marks when the update starts acting on what it sampled.
+enum frame_phase : uint8_t {
+    INPUT_PHASE,   // Input sampled into current_input, the update is about to read it
+    UPDATE_PHASE,  // update_game done
+    DRAW_PHASE,    // draw_game done
+    PRESENT_PHASE, // EndDrawing done: swapped, waited out the frame and polled input
+    FRAME_PHASE_COUNT
+};
+
+// One frame in microseconds, each phase as the offset of its end from the frame's begin
+struct frame_record {
+    uint64_t frame;
+    int64_t begin_us; // Since the session started
+    uint32_t phase_end_us[FRAME_PHASE_COUNT];
+    uint8_t state;    // game_state once the frame was over
+    uint8_t stutter;  // 1 if the frame went over budget
+    int16_t level;
+};
+
+// The frames around one stutter
+struct stutter_snapshot {
+    uint64_t stutter_frame;
+    std::vector<frame_record> frames;
+};
+
+// A telemetry file read back, for the tools
+struct telemetry_file {
+    uint32_t budget_us;
+    uint64_t total_frames;
+    uint64_t stutter_count;
+    std::vector<frame_record> frames;
+    std::vector<stutter_snapshot> snapshots;
+};
+
+// Per-frame timestamps of the last couple of minutes of play, kept in fixed buffers so
+// recording never allocates. Frames that take longer than the budget are stutters; the
+// frames around the most recent ones are kept apart so they survive the history wrapping.
+//
+// File layout, in the byte order of the machine that wrote it:
+//   "PFTL", u32 version, u32 budget_us, u32 frame count, u32 snapshot count,
+//   u64 total frames, u64 stutter count, the frames oldest first,
+//   then per snapshot: u64 stutter frame, u32 frame count and its frames
+// and per frame: u64 frame, i64 begin_us, u32 phase ends[4], u8 state, u8 stutter, i16 level
+class FrameTelemetry {
+public:
+    static constexpr size_t HISTORY = 1 << 13; // Over two minutes at 60 fps
+    static constexpr size_t STUTTER_CONTEXT = 30; // Frames kept on each side of a stutter
+    static constexpr size_t STUTTER_SNAPSHOTS = 16;
+    static constexpr double STUTTER_TOLERANCE = 1.5; // Of the frame budget, so one missed vsync counts
+    static constexpr uint32_t FILE_VERSION = 1;
+
+    [[nodiscard]] static FrameTelemetry &getInstance() {
+        static FrameTelemetry instance;
+        return instance;
+    }
+
+    FrameTelemetry(const FrameTelemetry&) = delete;
+    FrameTelemetry operator=(const FrameTelemetry&) = delete;
+
+    void set_frame_budget(double seconds);
+
+    void begin_frame();
+    void mark(frame_phase phase);
+    // Closes the frame, flags it if it was a stutter and returns it
+    const frame_record& end_frame(uint8_t state, int16_t level);
+
+    [[nodiscard]] uint64_t get_stutter_count() const;
+
+    // Returns false if the file could not be written
+    bool write(const std::string &path) const;
+    // Throws std::runtime_error on files that are not telemetry
+    [[nodiscard]] static telemetry_file read(const std::string &path);
+
+private:
+    FrameTelemetry() = default;
+    ~FrameTelemetry() = default;
+
+    static constexpr size_t SNAPSHOT_FRAMES = 2 * STUTTER_CONTEXT + 1;
+
+    struct snapshot_slot {
+        uint64_t stutter_frame;
+        size_t frame_count;
+        std::array<frame_record, SNAPSHOT_FRAMES> frames;
+    };
+
+    [[nodiscard]] int64_t now_us() const;
+    [[nodiscard]] uint64_t first_snapshot_frame() const;
+    void take_snapshot();
+
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    uint32_t budget_us = 16667;
+
+    std::array<frame_record, HISTORY> records{};
+    uint64_t frame_count = 0;
+    frame_record current{};
+
+    std::array<snapshot_slot, STUTTER_SNAPSHOTS> snapshots{};
+    uint64_t snapshot_count = 0;
+    uint64_t stutter_count = 0;
+    bool snapshot_pending = false;
+    uint64_t pending_stutter_frame = 0;
+};
+
+// --- Inline Definitions ---
+
+inline void FrameTelemetry::set_frame_budget(double seconds) {
+    budget_us = static_cast<uint32_t>(seconds * 1e6);
+}
+
+inline int64_t FrameTelemetry::now_us() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+inline void FrameTelemetry::begin_frame() {
+    current = {};
+    current.frame = frame_count;
+    current.begin_us = now_us();
+}
+
+inline void FrameTelemetry::mark(frame_phase phase) {
+    current.phase_end_us[phase] = static_cast<uint32_t>(now_us() - current.begin_us);
+}
+
+inline const frame_record& FrameTelemetry::end_frame(uint8_t state, int16_t level) {
+    current.state = state;
+    current.level = level;
+    current.stutter = current.phase_end_us[PRESENT_PHASE] > budget_us * STUTTER_TOLERANCE;
+
+    frame_record &stored = records[frame_count % HISTORY];
+    stored = current;
+    ++frame_count;
+
+    if (current.stutter) {
+        ++stutter_count;
+        // A stutter inside the window of a pending snapshot is already in it
+        if (!snapshot_pending) {
+            snapshot_pending = true;
+            pending_stutter_frame = current.frame;
+        }
+    }
+    if (snapshot_pending && frame_count > pending_stutter_frame + STUTTER_CONTEXT) {
+        take_snapshot();
+    }
+    return stored;
+}
+
+inline uint64_t FrameTelemetry::first_snapshot_frame() const {
+    return pending_stutter_frame >= STUTTER_CONTEXT ? pending_stutter_frame - STUTTER_CONTEXT : 0;
+}
+
+inline void FrameTelemetry::take_snapshot() {
+    // The oldest snapshot makes room for the newest
+    snapshot_slot &slot = snapshots[snapshot_count % STUTTER_SNAPSHOTS];
+    ++snapshot_count;
+    snapshot_pending = false;
+
+    const uint64_t first = first_snapshot_frame();
+    slot.stutter_frame = pending_stutter_frame;
+    slot.frame_count = static_cast<size_t>(frame_count - first);
+    for (size_t i = 0; i < slot.frame_count; ++i) {
+        slot.frames[i] = records[(first + i) % HISTORY];
+    }
+}
+
+inline uint64_t FrameTelemetry::get_stutter_count() const {
+    return stutter_count;
+}
+
+template <typename T>
+void write_telemetry_value(std::FILE *file, const T &value) {
+    std::fwrite(&value, sizeof(T), 1, file);
+}
+
+template <typename T>
+T read_telemetry_value(std::FILE *file) {
+    T value{};
+    if (std::fread(&value, sizeof(T), 1, file) != 1) throw std::runtime_error("Telemetry file ends early");
+    return value;
+}
+
+inline void write_frame_record(std::FILE *file, const frame_record &record) {
+    write_telemetry_value(file, record.frame);
+    write_telemetry_value(file, record.begin_us);
+    for (uint32_t phase_end : record.phase_end_us) write_telemetry_value(file, phase_end);
+    write_telemetry_value(file, record.state);
+    write_telemetry_value(file, record.stutter);
+    write_telemetry_value(file, record.level);
+}
+
+inline frame_record read_frame_record(std::FILE *file) {
+    frame_record record{};
+    record.frame = read_telemetry_value<uint64_t>(file);
+    record.begin_us = read_telemetry_value<int64_t>(file);
+    for (uint32_t &phase_end : record.phase_end_us) phase_end = read_telemetry_value<uint32_t>(file);
+    record.state = read_telemetry_value<uint8_t>(file);
+    record.stutter = read_telemetry_value<uint8_t>(file);
+    record.level = read_telemetry_value<int16_t>(file);
+    return record;
+}
+
+inline bool FrameTelemetry::write(const std::string &path) const {
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+
+    const uint64_t kept_frames = std::min<uint64_t>(frame_count, HISTORY);
+    const uint64_t kept_snapshots = std::min<uint64_t>(snapshot_count, STUTTER_SNAPSHOTS);
+    const uint64_t written_snapshots = kept_snapshots + (snapshot_pending ? 1 : 0);
+
+    std::fwrite("PFTL", 1, 4, file);
+    write_telemetry_value(file, FILE_VERSION);
+    write_telemetry_value(file, budget_us);
+    write_telemetry_value(file, static_cast<uint32_t>(kept_frames));
+    write_telemetry_value(file, static_cast<uint32_t>(written_snapshots));
+    write_telemetry_value(file, frame_count);
+    write_telemetry_value(file, stutter_count);
+
+    for (uint64_t frame = frame_count - kept_frames; frame < frame_count; ++frame) {
+        write_frame_record(file, records[frame % HISTORY]);
+    }
+    for (uint64_t snapshot = snapshot_count - kept_snapshots; snapshot < snapshot_count; ++snapshot) {
+        const snapshot_slot &slot = snapshots[snapshot % STUTTER_SNAPSHOTS];
+        write_telemetry_value(file, slot.stutter_frame);
+        write_telemetry_value(file, static_cast<uint32_t>(slot.frame_count));
+        for (size_t i = 0; i < slot.frame_count; ++i) {
+            write_frame_record(file, slot.frames[i]);
+        }
+    }
+
+    // A stutter too recent for its snapshot to be complete goes out with the frames after it so far
+    if (snapshot_pending) {
+        const uint64_t first = first_snapshot_frame();
+        write_telemetry_value(file, pending_stutter_frame);
+        write_telemetry_value(file, static_cast<uint32_t>(frame_count - first));
+        for (uint64_t frame = first; frame < frame_count; ++frame) {
+            write_frame_record(file, records[frame % HISTORY]);
+        }
+    }
+
+    const bool written = std::ferror(file) == 0;
+    std::fclose(file);
+    return written;
+}
+
+inline telemetry_file FrameTelemetry::read(const std::string &path) {
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) throw std::runtime_error("Could not open file: " + path);
+
+    telemetry_file telemetry{};
+    try {
+        char magic[4] = {};
+        if (std::fread(magic, 1, 4, file) != 4 || std::string(magic, 4) != "PFTL") {
+            throw std::runtime_error("Not a telemetry file: " + path);
+        }
+        if (read_telemetry_value<uint32_t>(file) != FILE_VERSION) {
+            throw std::runtime_error("Unsupported telemetry version: " + path);
+        }
+        telemetry.budget_us = read_telemetry_value<uint32_t>(file);
+        const uint32_t frames = read_telemetry_value<uint32_t>(file);
+        const uint32_t snapshot_total = read_telemetry_value<uint32_t>(file);
+        telemetry.total_frames = read_telemetry_value<uint64_t>(file);
+        telemetry.stutter_count = read_telemetry_value<uint64_t>(file);
+
+        // The counts come from the file, so they are checked before anything is sized by them
+        if (frames > HISTORY || snapshot_total > STUTTER_SNAPSHOTS + 1) {
+            throw std::runtime_error("Corrupt telemetry file: " + path);
+        }
+        telemetry.frames.reserve(frames);
+        for (uint32_t i = 0; i < frames; ++i) {
+            telemetry.frames.push_back(read_frame_record(file));
+        }
+        for (uint32_t i = 0; i < snapshot_total; ++i) {
+            stutter_snapshot snapshot;
+            snapshot.stutter_frame = read_telemetry_value<uint64_t>(file);
+            const uint32_t snapshot_frames = read_telemetry_value<uint32_t>(file);
+            if (snapshot_frames > SNAPSHOT_FRAMES) throw std::runtime_error("Corrupt stutter snapshot: " + path);
+            for (uint32_t frame = 0; frame < snapshot_frames; ++frame) {
+                snapshot.frames.push_back(read_frame_record(file));
+            }
+            telemetry.snapshots.push_back(std::move(snapshot));
+        }
+    } catch (...) {
+        std::fclose(file);
+        throw;
+    }
+    std::fclose(file);
+    return telemetry;
+}
+
+#endif // FRAME_TELEMETRY_H
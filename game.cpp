@@ -0,0 +1,218 @@
+#include "game.h"
+#include "raylib.h"
+#include "globals.h"
+#include "player.h"
+#include "level_controller.h"
+#include "enemies_controller.h"
+#include "audio_thread.h"
+#include "trace.h"
+#include <ctime>
+
+void update_game() {
+    TRACE_ZONE("update_game");
+
+    game_frame++;
+
+    switch (game_state) {
+        case MENU_STATE:
+            if (current_input.is_pressed(CONFIRM_ACTION)) {
+                SetExitKey(0);
+                game_state = GAME_STATE;
+                LevelController::getInstanceLevel().load_level(0);
+            } else if (current_input.is_pressed(ENDLESS_ACTION) && player_count == 1) {
+                SetExitKey(0);
+                game_state = GAME_STATE;
+                LevelController::getInstanceLevel().start_endless_mode(static_cast<uint64_t>(std::time(nullptr)));
+            }
+            break;
+
+        case GAME_STATE:
+            // Moving colliders go first, so the players react to where they are now
+            LevelController::getInstanceLevel().update_dynamic_colliders();
+
+            Player::getInstancePlayer().steer_players(player_count == 1 ? &current_input : player_inputs);
+            Player::getInstancePlayer().update_players();
+
+            EnemiesController::getInstance().update_enemies();
+            LevelController::getInstanceLevel().update_endless_level();
+
+            // Walk cycles only move on while playing
+            Player::getInstancePlayer().update_animations();
+            EnemiesController::getInstance().update_animations();
+
+            if (current_input.is_pressed(BACK_ACTION)) {
+                game_state = PAUSED_STATE;
+            }
+            break;
+
+        case PAUSED_STATE:
+            if (current_input.is_pressed(BACK_ACTION)) {
+                game_state = GAME_STATE;
+            }
+            break;
+
+        case DEATH_STATE:
+            Player::getInstancePlayer().update_player_gravity();
+
+            if (current_input.is_pressed(CONFIRM_ACTION)) {
+                if (player_lives > 0) {
+                    LevelController::getInstanceLevel().load_level(0);
+                    game_state = GAME_STATE;
+                }
+                else {
+                    game_state = GAME_OVER_STATE;
+                    AudioThread::getInstance().play(GAME_OVER_SOUND);
+                }
+            }
+            break;
+
+        case GAME_OVER_STATE:
+            if (current_input.is_pressed(CONFIRM_ACTION)) {
+                LevelController::getInstanceLevel().reset_level_index();
+                Player::getInstancePlayer().reset_player_stats();
+
+                // An endless run has no levels to restart from, so it ends back at the menu
+                if (LevelController::getInstanceLevel().is_endless()) {
+                    LevelController::getInstanceLevel().stop_endless_mode();
+                    game_state = MENU_STATE;
+                    SetExitKey(KEY_ESCAPE);
+                    break;
+                }
+                game_state = GAME_STATE;
+                LevelController::getInstanceLevel().load_level();
+            }
+            break;
+
+        case VICTORY_STATE:
+            if (current_input.is_pressed(CONFIRM_ACTION) || current_input.is_pressed(BACK_ACTION)) {
+                LevelController::getInstanceLevel().reset_level_index();
+                Player::getInstancePlayer().reset_player_stats();
+                game_state = MENU_STATE;
+                SetExitKey(KEY_ESCAPE);
+            }
+            break;
+    }
+}
+
+
+void step_game(const frame_input *inputs) {
+    frame_input combined{};
+    for (size_t player = 0; player < player_count; ++player) {
+        player_inputs[player] = inputs[player];
+        combined.held |= inputs[player].held;
+        combined.pressed |= inputs[player].pressed;
+    }
+    // Menus answer to whichever player presses first
+    current_input = combined;
+    update_game();
+}
+
+void save_game(game_snapshot &out) {
+    TRACE_ZONE("save_game");
+
+    LevelController::getInstanceLevel().save(out.level_state);
+    EnemiesController::getInstance().save(out.enemy_state);
+
+    out.state = static_cast<uint8_t>(game_state);
+    out.level = level_index;
+    out.timer = timer;
+    out.time_to_coin_counter = time_to_coin_counter;
+    out.lives = player_lives;
+    out.level_scores = player_level_scores;
+    out.frame = game_frame;
+    out.players = Player::getInstancePlayer().get_players();
+}
+
+void restore_game(const game_snapshot &in) {
+    TRACE_ZONE("restore_game");
+
+    LevelController::getInstanceLevel().restore(in.level_state);
+    EnemiesController::getInstance().restore(in.enemy_state);
+
+    game_state = static_cast<enum game_state>(in.state);
+    level_index = in.level;
+    timer = in.timer;
+    time_to_coin_counter = in.time_to_coin_counter;
+    player_lives = in.lives;
+    player_level_scores = in.level_scores;
+    game_frame = in.frame;
+    Player::getInstancePlayer().set_players(in.players);
+}
+
+namespace {
+
+struct fnv1a {
+    uint64_t hash = 14695981039346656037ull;
+
+    void add_bytes(const void *data, const size_t size) {
+        const auto *bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+
+    // Values one at a time, so struct padding never makes it into the hash
+    template <typename T>
+    void add(const T value) {
+        add_bytes(&value, sizeof(T));
+    }
+
+    void add(const Vector2 value) {
+        add(value.x);
+        add(value.y);
+    }
+
+    void add(const EnemyState &enemy) {
+        add(enemy.position);
+        add(enemy.direction);
+        add(enemy.patrol_lo);
+        add(enemy.patrol_hi);
+        add(enemy.y);
+    }
+};
+
+}
+
+uint64_t checksum_game(const game_snapshot &snapshot) {
+    fnv1a hash;
+    hash.add(snapshot.state);
+    hash.add(snapshot.level);
+    hash.add(snapshot.timer);
+    hash.add(snapshot.time_to_coin_counter);
+    hash.add(snapshot.lives);
+    for (const int score : snapshot.level_scores) hash.add(score);
+    hash.add(static_cast<uint64_t>(snapshot.frame));
+
+    snapshot.players.for_each<Position, Velocity, GroundContact, Facing>(
+        [&](const Position &position, const Velocity &velocity, const GroundContact &ground, const Facing &facing) {
+            hash.add(position.value);
+            hash.add(velocity.value);
+            hash.add(ground.on_ground);
+            hash.add(ground.collider);
+            hash.add(facing.forward);
+            hash.add(facing.moving);
+        });
+
+    // Tiles rarely change, so saving hashes them only when it copies a new revision
+    hash.add(snapshot.level_state.tile_hash);
+    const DynamicColliders &colliders = snapshot.level_state.colliders;
+    for (size_t i = 0; i < colliders.size(); ++i) {
+        const DynamicCollider &collider = colliders.get(static_cast<int32_t>(i));
+        hash.add(collider.position);
+        hash.add(collider.velocity);
+        hash.add(collider.state);
+        hash.add(collider.timer);
+    }
+
+    const EnemiesController::snapshot &enemies = snapshot.enemy_state;
+    for (size_t i = 0; i < enemies.enemies.size(); ++i) hash.add(enemies.enemies.get(i));
+    for (const auto &sleepers : enemies.dormant_chunks) {
+        for (const EnemiesController::DormantEnemy &sleeper : sleepers) {
+            hash.add(sleeper.state);
+            hash.add(sleeper.since_frame);
+        }
+    }
+    hash.add(enemies.simulated_frames);
+    enemies.chasers.for_each<Position>([&](const Position &position) { hash.add(position.value); });
+    return hash.hash;
+}
@@ -0,0 +1,40 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include "globals.h"
+#include "input.h"
+#include "level_controller.h"
+#include "enemies_controller.h"
+#include "player.h"
+#include <cstdint>
+#include <vector>
+
+// Advances the game by one frame on current_input, or on player_inputs when there are co-op players
+void update_game();
+
+// Advances the game by one frame with one input per player, as a rollback session does
+void step_game(const frame_input *inputs);
+
+// Every piece of state update_game reads or writes, so a frame can be taken back and played
+// again. Saving into the same snapshot reuses its buffers.
+struct game_snapshot {
+    uint8_t state;
+    int level;
+    int timer;
+    int time_to_coin_counter;
+    int lives;
+    std::vector<int> level_scores;
+    size_t frame;
+    PlayerArchetype players;
+    LevelController::snapshot level_state;
+    EnemiesController::snapshot enemy_state;
+};
+
+// Throws std::runtime_error in endless mode, whose level streams in on another thread
+void save_game(game_snapshot &out);
+void restore_game(const game_snapshot &in);
+
+// FNV-1a over the snapshot, floats by their bits, to tell whether two simulations diverged
+[[nodiscard]] uint64_t checksum_game(const game_snapshot &snapshot);
+
+#endif // GAME_H
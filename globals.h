@@ -3,24 +3,14 @@
 
 #include "raylib.h"
 #include "level.h"
+#include "tiles.h"
+#include "input.h"
 #include <vector>
 #include <string>
 #include <cstddef>
-
-/* Game Elements */
-
-inline const char WALL      = '#',
-                  WALL_DARK = '=',
-                  AIR       = '-',
-                  SPIKE     = '^',
-                  PLAYER    = '@',
-                  ENEMY     = '&',
-                  COIN      = '*',
-                  EXIT      = 'E';
-
+#include <cstdint>
 
 inline int level_index = 0;
-inline const int LEVEL_COUNT = 3;
 
 /* Timer-mechanic related */
 inline const int MAX_LEVEL_TIME = 50 * 60;
@@ -35,16 +25,37 @@ inline const float CEILING_BOUNCE_OFF    = 0.05f;
 inline const float ENEMY_MOVEMENT_SPEED  = 0.07f;
 inline const float BOUNCE_OFF_ENEMY      = 0.1f;
 inline const float GRAVITY_FORCE         = 0.01f;
+inline const float GROUND_SNAP_DISTANCE  = 0.1f;
 
-/* Player data */
+inline const int32_t ENEMY_MOVEMENT_STEP = 7; // ENEMY_MOVEMENT_SPEED in enemy subcells
 
-inline float player_y_velocity = 0;
+inline const float PLATFORM_MOVEMENT_SPEED = 0.05f;
+inline const float SPIKE_MOVEMENT_SPEED    = 0.04f;
+inline const int FALLING_BLOCK_DELAY       = 30; // Frames a falling block shakes before it drops
+inline const float CHASER_MOVEMENT_SPEED   = 0.04f;
 
-inline int player_level_scores[LEVEL_COUNT];
+/* Simulation level of detail */
+
+// Enemies whose patrol lies further than this many columns beyond the screen edges are
+// put to sleep and fast-forwarded when they come back, instead of being stepped every frame
+inline float enemy_simulation_margin = 16.0f;
+// The widest screen the simulation window is sized for. The window is part of the simulation, so
+// it comes from the level's rows and this instead of this machine's screen, and co-op peers agree.
+inline const float SIMULATION_VIEW_ASPECT = 32.0f / 9.0f;
+
+/* Player data */
+
+inline std::vector<int> player_level_scores; // One per level in the levels file
 
 inline const int MAX_PLAYER_LIVES = 3;
 inline int player_lives = MAX_PLAYER_LIVES;
 
+// Co-op players share the level, the lives and the score; each is an entity of the Player
+// singleton's archetype
+inline const size_t MAX_PLAYERS = 2;
+inline size_t player_count = 1;
+inline size_t local_player = 0; // The one this machine controls and the camera follows
+
 /* Graphic Metrics */
 
 // UI
@@ -90,6 +101,11 @@ inline Text game_subtitle = {
     {0.50f, 0.65f}
 };
 
+inline Text game_endless_subtitle = {
+    "Press E for Endless Mode",
+    {0.50f, 0.72f}
+};
+
 inline Text game_paused = {
     "Press Escape to Resume"
 };
@@ -130,15 +146,25 @@ inline Text victory_subtitle = {
     {0.50f, 0.65f}
 };
 
+/* Headless Drawing */
+
+// A texture blit that draw_image would have issued
+struct draw_command {
+    unsigned int texture_id;
+    Rectangle destination;
+};
+
+// When set, draw_image records its blits here instead of drawing them, so the drawing code
+// can run without a window, e.g. in the benchmarks
+inline std::vector<draw_command> *draw_command_capture = nullptr;
+
 /* Images and Sprites */
 
+// The frames of an animation; which one to show is up to the animated instance, see animation.h
 struct sprite {
     size_t frame_count    = 0;
-    size_t frames_to_skip = 3;
-    size_t frames_skipped = 0;
-    size_t frame_index    = 0;
+    size_t frames_to_skip = 3; // Ticks a frame stays on screen after the first
     bool loop = true;
-    size_t prev_game_frame = 0;
     Texture2D *frames = nullptr;
 };
 
@@ -171,13 +197,17 @@ inline Texture2D foreground;
 
 /* Sounds */
 
-inline Music music;
+enum sound_id : uint8_t {
+    COIN_SOUND,
+    EXIT_SOUND,
+    PLAYER_DEATH_SOUND,
+    KILL_ENEMY_SOUND,
+    GAME_OVER_SOUND,
+    SOUND_COUNT
+};
 
-inline Sound coin_sound;
-inline Sound exit_sound;
-inline Sound player_death_sound;
-inline Sound kill_enemy_sound;
-inline Sound game_over_sound;
+// Sound effects are decoded into memory while they fit in this, the rest are streamed
+inline const size_t AUDIO_MEMORY_BUDGET = 2 * 1024 * 1024;
 
 /* Victory Menu Background */
 
@@ -197,8 +227,48 @@ inline victory_ball victory_balls[VICTORY_BALL_COUNT];
 
 /* Frame Counter */
 
+inline const int TARGET_FPS = 60;
 inline size_t game_frame = 0;
 
+// Controls of the current frame, from the keyboard or a replay
+inline frame_input current_input;
+// With more than one player, each one's controls; current_input then has all of them combined
+inline frame_input player_inputs[MAX_PLAYERS];
+
+/* Performance Counters */
+
+// Bumped by the hot paths as they run; the main loop moves them to last_frame_counters
+// at the start of every frame for the performance HUD
+struct frame_counters {
+    size_t tiles_visited = 0;     // Cells in the rectangle draw_level scans
+    size_t tiles_drawn = 0;
+    size_t draw_calls = 0;        // Texture blits through draw_image
+    size_t collision_queries = 0; // Tile, sweep and enemy hitbox tests
+    size_t active_enemies = 0;    // Enemies stepped by update_enemies, chasers included
+    size_t allocations = 0;
+};
+
+inline frame_counters current_frame_counters;
+inline frame_counters last_frame_counters;
+
+// Loading a level allocates, so the zero allocation check starts over after every load
+inline size_t level_load_count = 0;
+inline const size_t ZERO_ALLOCATION_WARMUP_FRAMES = 120;
+
+// Frame, update and draw times in milliseconds of the most recent frames, oldest overwritten first
+inline const size_t FRAME_TIMING_HISTORY = 240;
+
+struct frame_timing {
+    float frame_ms;
+    float update_ms;
+    float draw_ms;
+};
+
+inline frame_timing frame_timings[FRAME_TIMING_HISTORY];
+inline size_t frame_timing_count = 0;
+
+inline bool performance_hud_visible = false;
+
 /* Game States */
 
 enum game_state {
@@ -218,6 +288,7 @@ inline game_state game_state = MENU_STATE;
 void draw_text(Text &text);
 void derive_graphics_metrics_from_loaded_level();
 void draw_game_overlay();
+void draw_performance_hud();
 //void draw_level();
 //void draw_player();
 void draw_enemies();
@@ -251,8 +322,8 @@ sprite load_sprite(
         size_t frames_to_skip = 3
 );
 void unload_sprite(sprite &sprite);
-void draw_sprite(sprite &sprite, Vector2 pos, float width, float height);
-void draw_sprite(sprite &sprite, Vector2 pos, float size);
+void draw_sprite(const sprite &sprite, size_t frame_index, Vector2 pos, float width, float height);
+void draw_sprite(const sprite &sprite, size_t frame_index, Vector2 pos, float size);
 
 void load_sounds();
 void unload_sounds();
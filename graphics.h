@@ -6,6 +6,13 @@
 #include "enemies_controller.h"
 #include "player.h"
 #include "utilities.h"
+#include "trace.h"
+#include "animation.h"
+#include "frame_telemetry.h"
+#include "sound_bank.h"
+#include "input_latency.h"
+#include <algorithm>
+#include <cstdio>
 
 void draw_text(Text &text) {
     // Measure the text, center it to the required position, and draw it
@@ -24,7 +31,7 @@ void derive_graphics_metrics_from_loaded_level() {
     screen_size.x  = static_cast<float>(GetScreenWidth());
     screen_size.y = static_cast<float>(GetScreenHeight());
 
-    cell_size = screen_size.y / static_cast<float>(LevelController::getInstanceLevel().get_levels()[level_index].get_rows());    screen_scale = std::min(screen_size.x, screen_size.y) / SCREEN_SCALE_DIVISOR;
+    cell_size = screen_size.y / static_cast<float>(LevelController::getInstanceLevel().get_current_level().get_rows());    screen_scale = std::min(screen_size.x, screen_size.y) / SCREEN_SCALE_DIVISOR;
 
     // Parallax background setup
     float larger_screen_side = std::max(screen_size.x, screen_size.y);
@@ -39,8 +46,11 @@ void derive_graphics_metrics_from_loaded_level() {
 }
 
 void draw_parallax_background() {
-    // First uses the player's position
-    float initial_offset      = -(Player::getInstancePlayer().get_player_posX() * PARALLAX_PLAYER_SCROLLING_SPEED + game_frame * PARALLAX_IDLE_SCROLLING_SPEED);
+    TRACE_ZONE("draw_parallax_background");
+
+    // First uses the player's position, counting the columns an endless level has scrolled away
+    float player_x            = Player::getInstancePlayer().get_player_posX(local_player) + static_cast<float>(LevelController::getInstanceLevel().get_scrolled_columns());
+    float initial_offset      = -(player_x * PARALLAX_PLAYER_SCROLLING_SPEED + game_frame * PARALLAX_IDLE_SCROLLING_SPEED);
 
     // Calculate offsets for different layers
     float background_offset   = initial_offset;
@@ -81,22 +91,85 @@ void draw_game_overlay() {
         draw_image(heart_image, {ICON_SIZE * i + SPACE_BETWEEN_HEARTS, slight_vertical_offset}, ICON_SIZE);
     }
 
-    // Timer
-    Vector2 timer_dimensions = MeasureTextEx(menu_font, std::to_string(timer / 60).c_str(), ICON_SIZE, 2.0f);
+    // Timer, formatted on the stack so drawing it every frame does not allocate
+    char timer_text[16];
+    std::snprintf(timer_text, sizeof(timer_text), "%d", timer / 60);
+    Vector2 timer_dimensions = MeasureTextEx(menu_font, timer_text, ICON_SIZE, 2.0f);
     Vector2 timer_position = {(GetRenderWidth() - timer_dimensions.x) * 0.5f, slight_vertical_offset};
-    DrawTextEx(menu_font, std::to_string(timer / 60).c_str(), timer_position, ICON_SIZE, 2.0f, WHITE);
+    DrawTextEx(menu_font, timer_text, timer_position, ICON_SIZE, 2.0f, WHITE);
 
     // Score
-    Vector2 score_dimensions = MeasureTextEx(menu_font, std::to_string(Player::getInstancePlayer().get_total_player_score()).c_str(), ICON_SIZE, 2.0f);
+    char score_text[16];
+    std::snprintf(score_text, sizeof(score_text), "%d", Player::getInstancePlayer().get_total_player_score());
+    Vector2 score_dimensions = MeasureTextEx(menu_font, score_text, ICON_SIZE, 2.0f);
     Vector2 score_position = {GetRenderWidth() - score_dimensions.x - ICON_SIZE, slight_vertical_offset};
-    DrawTextEx(menu_font, std::to_string(Player::getInstancePlayer().get_total_player_score()).c_str(), score_position, ICON_SIZE, 2.0f, WHITE);
-    draw_sprite(coin_sprite, {GetRenderWidth() - ICON_SIZE, slight_vertical_offset}, ICON_SIZE);
+    DrawTextEx(menu_font, score_text, score_position, ICON_SIZE, 2.0f, WHITE);
+    draw_sprite(coin_sprite, sprite_frame(coin_sprite, game_frame), {GetRenderWidth() - ICON_SIZE, slight_vertical_offset}, ICON_SIZE);
+}
+
+void draw_performance_hud() {
+    const float FONT_SIZE = 14.0f * screen_scale;
+    const float LINE_HEIGHT = FONT_SIZE * 1.6f;
+    const Vector2 ORIGIN = {8.0f * screen_scale, 64.0f * screen_scale};
+
+    // Frame time spread over the recorded frames; everything stays on the stack so the HUD
+    // does not show up in the allocation count it reports
+    size_t count = std::min(frame_timing_count, FRAME_TIMING_HISTORY);
+    float frame_ms[FRAME_TIMING_HISTORY];
+    float min_ms = 0.0f, average_ms = 0.0f, update_ms = 0.0f, draw_ms = 0.0f, p99_ms = 0.0f;
+    if (count > 0) {
+        min_ms = frame_timings[0].frame_ms;
+        for (size_t i = 0; i < count; ++i) {
+            frame_ms[i] = frame_timings[i].frame_ms;
+            min_ms = std::min(min_ms, frame_timings[i].frame_ms);
+            average_ms += frame_timings[i].frame_ms;
+            update_ms += frame_timings[i].update_ms;
+            draw_ms += frame_timings[i].draw_ms;
+        }
+        average_ms /= static_cast<float>(count);
+        update_ms /= static_cast<float>(count);
+        draw_ms /= static_cast<float>(count);
+
+        size_t p99_index = std::min(count - 1, count * 99 / 100);
+        std::nth_element(frame_ms, frame_ms + p99_index, frame_ms + count);
+        p99_ms = frame_ms[p99_index];
+    }
+
+    const frame_counters &counters = last_frame_counters;
+    const SoundBank &sounds = SoundBank::getInstance();
+    char lines[10][64];
+    std::snprintf(lines[0], sizeof(lines[0]), "FRAME %.2f / %.2f / %.2f MS", min_ms, average_ms, p99_ms);
+    std::snprintf(lines[1], sizeof(lines[1]), "UPDATE %.2f MS  DRAW %.2f MS", update_ms, draw_ms);
+    std::snprintf(lines[2], sizeof(lines[2]), "TILES %zu VISITED %zu DRAWN", counters.tiles_visited, counters.tiles_drawn);
+    std::snprintf(lines[3], sizeof(lines[3]), "DRAW CALLS %zu", counters.draw_calls);
+    std::snprintf(lines[4], sizeof(lines[4]), "COLLISION QUERIES %zu", counters.collision_queries);
+    std::snprintf(lines[5], sizeof(lines[5]), "ENEMIES %zu / %zu", counters.active_enemies, EnemiesController::getInstance().get_enemy_count());
+    std::snprintf(lines[6], sizeof(lines[6]), "ALLOCATIONS %zu", counters.allocations);
+    std::snprintf(lines[7], sizeof(lines[7]), "STUTTERS %llu",
+                  static_cast<unsigned long long>(FrameTelemetry::getInstance().get_stutter_count()));
+    std::snprintf(lines[8], sizeof(lines[8]), "AUDIO %zu KB  %zu STREAMED", sounds.get_resident_bytes() / 1024,
+                  sounds.get_streamed_count());
+    if (InputLatency::getInstance().is_enabled()) {
+        const latency_summary latency = InputLatency::getInstance().summarize();
+        std::snprintf(lines[9], sizeof(lines[9]), "LATENCY %.1f / %.1f / %.1f MS", latency.median_ms, latency.p99_ms,
+                      latency.max_ms);
+    } else {
+        std::snprintf(lines[9], sizeof(lines[9]), "LATENCY OFF");
+    }
+
+    DrawRectangle(0, static_cast<int>(ORIGIN.y - LINE_HEIGHT * 0.5f), static_cast<int>(FONT_SIZE * 32.0f),
+                  static_cast<int>(LINE_HEIGHT * 11.0f), {0, 0, 0, 160});
+    for (size_t i = 0; i < 10; ++i) {
+        Vector2 position = {ORIGIN.x, ORIGIN.y + LINE_HEIGHT * static_cast<float>(i)};
+        DrawTextEx(menu_font, lines[i], position, FONT_SIZE, 1.0f, i == 6 && counters.allocations > 0 ? YELLOW : WHITE);
+    }
 }
 
 // Menus
 void draw_menu() {
     draw_text(game_title);
     draw_text(game_subtitle);
+    draw_text(game_endless_subtitle);
 }
 
 void draw_pause_menu() {
@@ -0,0 +1,90 @@
+#include "heap_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// Replaces the global allocation functions to count allocations, for the performance HUD,
+// the zero allocation check, the trace zones and the benchmarks. Kept in a file of its own
+// so no call site sees new and free side by side. The nothrow forms call these, so they are
+// counted too.
+
+static void* allocate(std::size_t size) {
+    heap_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    ++thread_heap_allocation_count;
+    if (void *memory = std::malloc(size > 0 ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+// For types aligned past what malloc guarantees
+static void* allocate_aligned(std::size_t size, std::align_val_t alignment) {
+    heap_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    ++thread_heap_allocation_count;
+    size = size > 0 ? size : 1;
+#ifdef _WIN32
+    if (void *memory = _aligned_malloc(size, static_cast<std::size_t>(alignment))) return memory;
+#else
+    void *memory = nullptr;
+    if (posix_memalign(&memory, static_cast<std::size_t>(alignment), size) == 0) return memory;
+#endif
+    throw std::bad_alloc();
+}
+
+static void free_aligned(void *memory) {
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate_aligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocate_aligned(size, alignment);
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void *memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::align_val_t) noexcept {
+    free_aligned(memory);
+}
+
+void operator delete(void *memory, std::size_t, std::align_val_t) noexcept {
+    free_aligned(memory);
+}
+
+void operator delete[](void *memory, std::align_val_t) noexcept {
+    free_aligned(memory);
+}
+
+void operator delete[](void *memory, std::size_t, std::align_val_t) noexcept {
+    free_aligned(memory);
+}
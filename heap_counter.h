@@ -0,0 +1,14 @@
+#ifndef HEAP_COUNTER_H
+#define HEAP_COUNTER_H
+
+#include <atomic>
+#include <cstddef>
+
+// Heap allocations made through operator new. heap_counter.cpp replaces the global allocation
+// functions to keep these up to date; executables that do not link it always read zero.
+inline std::atomic<size_t> heap_allocation_count{0};
+
+// The calling thread's share, so trace zones can tell which of them allocated
+inline thread_local size_t thread_heap_allocation_count = 0;
+
+#endif // HEAP_COUNTER_H
@@ -0,0 +1,156 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include "raylib.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// The game reads its controls through one frame_input sampled at the start of each frame,
+// never from the keyboard directly, so a run can be recorded and replayed frame for frame.
+enum input_action : uint8_t {
+    MOVE_RIGHT_ACTION,
+    MOVE_LEFT_ACTION,
+    JUMP_ACTION,
+    CONFIRM_ACTION, // Enter
+    BACK_ACTION,    // Escape
+    ENDLESS_ACTION, // E on the menu
+    HUD_ACTION,     // F3
+    TRACE_ACTION,   // F9
+    INPUT_ACTION_COUNT
+};
+
+static_assert(INPUT_ACTION_COUNT <= 8, "frame_input keeps one bit per action in a byte");
+
+struct frame_input {
+    uint8_t held = 0;    // One bit per input_action
+    uint8_t pressed = 0; // Went down this frame
+
+    [[nodiscard]] bool is_held(input_action action) const {
+        return (held >> action) & 1;
+    }
+
+    [[nodiscard]] bool is_pressed(input_action action) const {
+        return (pressed >> action) & 1;
+    }
+};
+
+[[nodiscard]] frame_input sample_input();
+
+// Writes the input of every frame to a file as it is played, or plays back such a file
+// instead of the keyboard. Recording goes straight through a FILE so it never allocates.
+//
+// File layout: "PINP", u32 version, then per frame: u8 held, u8 pressed
+class InputReplay {
+public:
+    static constexpr uint32_t FILE_VERSION = 1;
+
+    InputReplay() = default;
+    ~InputReplay();
+
+    InputReplay(const InputReplay&) = delete;
+    InputReplay& operator=(const InputReplay&) = delete;
+
+    // Both throw std::runtime_error if the file cannot be used
+    void start_recording(const std::string &path);
+    void start_replaying(const std::string &path);
+
+    // The input of the next frame: the replayed one while replaying, the live one otherwise
+    [[nodiscard]] frame_input next(const frame_input &live);
+
+    [[nodiscard]] bool is_replaying() const;
+    [[nodiscard]] bool is_finished() const;
+
+private:
+    std::FILE *recording = nullptr;
+    std::vector<frame_input> replay;
+    size_t replay_position = 0;
+    bool replaying = false;
+};
+
+// --- Inline Definitions ---
+
+inline frame_input sample_input() {
+    struct binding {
+        input_action action;
+        int key;
+    };
+    static constexpr binding BINDINGS[] = {
+        {MOVE_RIGHT_ACTION, KEY_RIGHT}, {MOVE_RIGHT_ACTION, KEY_D},
+        {MOVE_LEFT_ACTION,  KEY_LEFT},  {MOVE_LEFT_ACTION,  KEY_A},
+        {JUMP_ACTION,       KEY_UP},    {JUMP_ACTION,       KEY_W}, {JUMP_ACTION, KEY_SPACE},
+        {CONFIRM_ACTION,    KEY_ENTER},
+        {BACK_ACTION,       KEY_ESCAPE},
+        {ENDLESS_ACTION,    KEY_E},
+        {HUD_ACTION,        KEY_F3},
+        {TRACE_ACTION,      KEY_F9}
+    };
+
+    frame_input input;
+    for (const binding &bound : BINDINGS) {
+        if (IsKeyDown(bound.key)) input.held |= static_cast<uint8_t>(1 << bound.action);
+        if (IsKeyPressed(bound.key)) input.pressed |= static_cast<uint8_t>(1 << bound.action);
+    }
+    return input;
+}
+
+inline InputReplay::~InputReplay() {
+    if (recording != nullptr) std::fclose(recording);
+}
+
+inline void InputReplay::start_recording(const std::string &path) {
+    recording = std::fopen(path.c_str(), "wb");
+    if (recording == nullptr) throw std::runtime_error("Could not open file: " + path);
+
+    std::fwrite("PINP", 1, 4, recording);
+    std::fwrite(&FILE_VERSION, sizeof(FILE_VERSION), 1, recording);
+}
+
+inline void InputReplay::start_replaying(const std::string &path) {
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) throw std::runtime_error("Could not open file: " + path);
+
+    char magic[4] = {};
+    uint32_t version = 0;
+    const bool valid = std::fread(magic, 1, 4, file) == 4 && std::string(magic, 4) == "PINP" &&
+                       std::fread(&version, sizeof(version), 1, file) == 1 && version == FILE_VERSION;
+    if (!valid) {
+        std::fclose(file);
+        throw std::runtime_error("Not an input replay: " + path);
+    }
+
+    uint8_t bits[2];
+    while (std::fread(bits, 1, 2, file) == 2) {
+        replay.push_back({bits[0], bits[1]});
+    }
+    std::fclose(file);
+
+    replay_position = 0;
+    replaying = true;
+}
+
+inline frame_input InputReplay::next(const frame_input &live) {
+    frame_input input = live;
+    if (replaying) {
+        input = replay_position < replay.size() ? replay[replay_position++] : frame_input{};
+    }
+
+    if (recording != nullptr) {
+        const uint8_t bits[2] = {input.held, input.pressed};
+        std::fwrite(bits, 1, 2, recording);
+    }
+    return input;
+}
+
+inline bool InputReplay::is_replaying() const {
+    return replaying;
+}
+
+inline bool InputReplay::is_finished() const {
+    return replaying && replay_position >= replay.size();
+}
+
+#endif // INPUT_H
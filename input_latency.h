@@ -0,0 +1,215 @@
+#ifndef INPUT_LATENCY_H
+#define INPUT_LATENCY_H
+
+#include "raylib.h"
+#include "input.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Input-to-present latency. Every frame whose input holds a new edge (a control going down
+// or up) is stamped with when the poll that first saw the edge ran and with when the frame
+// was presented, that is when EndDrawing returned from the swap. The full input-to-photon
+// time adds the wait from the key press to that poll (half a frame on average) and the
+// display's own delay after the swap, neither of which the game can see.
+struct latency_sample {
+    uint64_t frame;
+    int64_t edge_us;    // Since the recorder was created
+    int64_t present_us;
+};
+
+struct latency_summary {
+    size_t count;
+    float median_ms;
+    float p95_ms;
+    float p99_ms;
+    float max_ms;
+};
+
+class InputLatency {
+public:
+    static constexpr size_t HISTORY = 1 << 12;
+
+    [[nodiscard]] static InputLatency &getInstance() {
+        static InputLatency instance;
+        return instance;
+    }
+
+    InputLatency(const InputLatency&) = delete;
+    InputLatency& operator=(const InputLatency&) = delete;
+
+    void set_enabled(bool enabled);
+    [[nodiscard]] bool is_enabled() const;
+
+    [[nodiscard]] int64_t now_us() const;
+    void record(uint64_t frame, int64_t edge_us, int64_t present_us);
+
+    // Over the newest HISTORY edges; allocation-free, so the HUD can call it every frame
+    [[nodiscard]] latency_summary summarize() const;
+
+    // One row per edge; returns false if the file could not be written
+    bool write_csv(const std::string &path, const char *mode) const;
+
+private:
+    InputLatency() = default;
+    ~InputLatency() = default;
+
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    bool enabled = false;
+
+    std::array<latency_sample, HISTORY> samples{};
+    uint64_t sample_count = 0;
+};
+
+// The input of one frame and when its first new edge was polled, or -1 without one
+struct latched_input {
+    frame_input input;
+    int64_t edge_us;
+};
+
+// Samples the input for each frame. By default that is what the poll at the end of the last
+// EndDrawing saw, so with vsync the input waits out the slack of the frame before reaching
+// the screen. With the late latch on, the frame first sleeps until just enough time is left
+// to update and draw before the next present, then polls again. The work is predicted from
+// the slowest of the recent frames and the sleep is bounded, so a misprediction costs at most
+// MAX_WAIT_US of extra frame time.
+class InputLatch {
+public:
+    static constexpr int64_t SAFETY_MARGIN_US = 2000;
+    static constexpr int64_t MAX_WAIT_US = 8000;
+    static constexpr size_t WORK_HISTORY = 30;
+
+    void set_late(bool late_latch, double frame_budget_seconds);
+    [[nodiscard]] bool is_late() const;
+
+    // Right after BeginDrawing, so raylib counts the wait as part of the frame
+    [[nodiscard]] latched_input latch();
+    // Right after EndDrawing; work_us is how long the update and draw took
+    void presented(int64_t present_us, int64_t work_us);
+
+private:
+    [[nodiscard]] bool has_edge(const frame_input &input) const;
+    [[nodiscard]] int64_t predicted_work_us() const;
+
+    bool late = false;
+    int64_t budget_us = 16667;
+    int64_t last_present_us = 0;
+    uint8_t previous_held = 0;
+
+    std::array<int64_t, WORK_HISTORY> work_us{};
+    size_t work_count = 0;
+};
+
+// --- Inline Definitions ---
+
+inline void InputLatency::set_enabled(bool enable) {
+    enabled = enable;
+}
+
+inline bool InputLatency::is_enabled() const {
+    return enabled;
+}
+
+inline int64_t InputLatency::now_us() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+inline void InputLatency::record(uint64_t frame, int64_t edge_us, int64_t present_us) {
+    if (!enabled) return;
+    samples[sample_count % HISTORY] = {frame, edge_us, present_us};
+    ++sample_count;
+}
+
+inline latency_summary InputLatency::summarize() const {
+    const size_t count = static_cast<size_t>(std::min<uint64_t>(sample_count, HISTORY));
+    latency_summary summary = {count, 0.0f, 0.0f, 0.0f, 0.0f};
+    if (count == 0) return summary;
+
+    std::array<float, HISTORY> latencies_ms;
+    for (size_t i = 0; i < count; ++i) {
+        latencies_ms[i] = static_cast<float>(samples[i].present_us - samples[i].edge_us) / 1000.0f;
+    }
+
+    auto percentile = [&](size_t percent) {
+        const size_t index = std::min(count - 1, count * percent / 100);
+        std::nth_element(latencies_ms.begin(), latencies_ms.begin() + index, latencies_ms.begin() + count);
+        return latencies_ms[index];
+    };
+    summary.median_ms = percentile(50);
+    summary.p95_ms = percentile(95);
+    summary.p99_ms = percentile(99);
+    summary.max_ms = *std::max_element(latencies_ms.begin(), latencies_ms.begin() + count);
+    return summary;
+}
+
+inline bool InputLatency::write_csv(const std::string &path, const char *mode) const {
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) return false;
+
+    std::fprintf(file, "mode,frame,edge_us,present_us,latency_us\n");
+    const uint64_t kept = std::min<uint64_t>(sample_count, HISTORY);
+    for (uint64_t index = sample_count - kept; index < sample_count; ++index) {
+        const latency_sample &sample = samples[index % HISTORY];
+        std::fprintf(file, "%s,%llu,%lld,%lld,%lld\n", mode, static_cast<unsigned long long>(sample.frame),
+                     static_cast<long long>(sample.edge_us), static_cast<long long>(sample.present_us),
+                     static_cast<long long>(sample.present_us - sample.edge_us));
+    }
+
+    const bool written = std::ferror(file) == 0;
+    std::fclose(file);
+    return written;
+}
+
+inline void InputLatch::set_late(bool late_latch, double frame_budget_seconds) {
+    late = late_latch;
+    budget_us = static_cast<int64_t>(frame_budget_seconds * 1e6);
+}
+
+inline bool InputLatch::is_late() const {
+    return late;
+}
+
+inline bool InputLatch::has_edge(const frame_input &input) const {
+    return input.pressed != 0 || (previous_held & ~input.held) != 0;
+}
+
+inline int64_t InputLatch::predicted_work_us() const {
+    const size_t count = std::min(work_count, WORK_HISTORY);
+    return count == 0 ? budget_us / 2 : *std::max_element(work_us.begin(), work_us.begin() + count);
+}
+
+inline latched_input InputLatch::latch() {
+    // EndDrawing polls last, so the input it saw was polled when the previous frame was presented
+    latched_input latched = {sample_input(), -1};
+    if (has_edge(latched.input)) latched.edge_us = last_present_us;
+
+    if (late) {
+        const InputLatency &clock = InputLatency::getInstance();
+        const int64_t deadline_us = last_present_us + budget_us - predicted_work_us() - SAFETY_MARGIN_US;
+        const int64_t wait_us = std::clamp<int64_t>(deadline_us - clock.now_us(), 0, MAX_WAIT_US);
+        if (wait_us > 0) WaitTime(static_cast<double>(wait_us) / 1e6);
+
+        PollInputEvents();
+        const int64_t poll_us = clock.now_us();
+        frame_input later = sample_input();
+
+        // The second poll starts its edges over, so presses the first one saw are carried along
+        later.pressed |= latched.input.pressed;
+        if (latched.edge_us < 0 && has_edge(later)) latched.edge_us = poll_us;
+        latched.input = later;
+    }
+
+    previous_held = latched.input.held;
+    return latched;
+}
+
+inline void InputLatch::presented(int64_t present_us, int64_t work) {
+    last_present_us = present_us;
+    work_us[work_count++ % WORK_HISTORY] = work;
+}
+
+#endif // INPUT_LATENCY_H
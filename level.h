@@ -1,6 +1,8 @@
 #ifndef LEVEL_H
 #define LEVEL_H
 
+#include "tile_grid.h"
+#include "tile_bitplanes.h"
 #include <cstddef>
 
 class LevelController;
@@ -8,55 +10,80 @@ class LevelController;
 class Level {
 public:
     Level();
-    Level(size_t row_count, size_t column_count, char* level_data);
+    Level(size_t row_count, size_t column_count);
 
     [[nodiscard]] size_t get_rows() const;
-    void set_rows(size_t row_count);
-
     [[nodiscard]] size_t get_columns() const;
-    void set_columns(size_t column_count);
 
-    [[nodiscard]] const char* get_data() const;
-    void set_data(char* level_data);
+    [[nodiscard]] char get_cell(size_t row_index, size_t column_index) const;
+    void set_cell(size_t row_index, size_t column_index, char new_value);
+
+    [[nodiscard]] const PackedTileGrid& get_tiles() const;
+    [[nodiscard]] const TileBitplanes& get_bitplanes() const;
+
+    // Unpacks a level template into this level, rebuilding the bitplanes
+    void load_from(const CompressedTileGrid &source);
+    // Drops as many columns on the left as the chunk has and appends the chunk on the right
+    void scroll(const PackedTileGrid &chunk);
+    // Room for this many spawn and dynamic tiles, so that scrolling never allocates
+    void reserve_markers(size_t count);
 
-    static char& get_level_cell(size_t row_index, size_t column_index);
+    static char get_level_cell(size_t row_index, size_t column_index);
 
 private:
-    size_t rows;
-    size_t columns;
-    char* data;
+    PackedTileGrid tiles;
+    TileBitplanes bitplanes;
 };
 
 // --- Inline Definitions ---
 
 inline Level::Level()
-    : rows(0), columns(0), data(nullptr) {}
+    : tiles() {}
 
-inline Level::Level(size_t row_count, size_t column_count, char* level_data)
-    : rows(row_count), columns(column_count), data(level_data) {}
+inline Level::Level(size_t row_count, size_t column_count)
+    : tiles(row_count, column_count) {
+    bitplanes.rebuild(tiles);
+}
 
 inline size_t Level::get_rows() const {
-    return rows;
+    return tiles.get_rows();
 }
 
-inline void Level::set_rows(size_t row_count) {
-    rows = row_count;
+inline size_t Level::get_columns() const {
+    return tiles.get_columns();
 }
 
-inline size_t Level::get_columns() const {
-    return columns;
+inline char Level::get_cell(size_t row_index, size_t column_index) const {
+    return tiles.get(row_index, column_index);
+}
+
+inline void Level::set_cell(size_t row_index, size_t column_index, char new_value) {
+    bitplanes.set(row_index, column_index, tiles.get_kind(row_index, column_index), tile_kind_of(new_value));
+    tiles.set(row_index, column_index, new_value);
+}
+
+inline const PackedTileGrid& Level::get_tiles() const {
+    return tiles;
+}
+
+inline const TileBitplanes& Level::get_bitplanes() const {
+    return bitplanes;
 }
 
-inline void Level::set_columns(size_t column_count) {
-    columns = column_count;
+inline void Level::load_from(const CompressedTileGrid &source) {
+    tiles = PackedTileGrid{source.get_rows(), source.get_columns()};
+    source.unpack_into(tiles);
+    bitplanes.rebuild(tiles);
 }
 
-inline const char* Level::get_data() const {
-    return data;
+inline void Level::scroll(const PackedTileGrid &chunk) {
+    tiles.shift_left(chunk.get_columns());
+    tiles.copy_columns(chunk, tiles.get_columns() - chunk.get_columns());
+    bitplanes.rebuild(tiles);
 }
 
-inline void Level::set_data(char* level_data) {
-    data = level_data;
+inline void Level::reserve_markers(size_t count) {
+    bitplanes.reserve_markers(count);
 }
 
 #endif // LEVEL_H
@@ -4,8 +4,15 @@
 #include "raylib.h"
 #include "globals.h"
 #include "player.h"
+#include "animation.h"
+#include "trace.h"
 #include <fstream>
+#include <functional>
 #include <exception>
+#include <stdexcept>
+#include <cmath>
+#include <algorithm>
+#include <utility>
 
 // Singleton accessor
 LevelController& LevelController::getInstanceLevel()
@@ -23,46 +30,31 @@ bool LevelController::is_inside_level(int row, int column)
 }
 
 // Collision detection
+TileContacts LevelController::query_tiles(Vector2 pos) const
+{
+    // One pass over the bitplanes finds every tile kind the hitbox touches,
+    // then the moving colliders next to it add their kinds
+    ++current_frame_counters.collision_queries;
+    TileContacts contacts = current_level.get_bitplanes().query(pos);
+    dynamic_colliders.add_contacts(pos, contacts);
+    return contacts;
+}
+
 bool LevelController::is_colliding(Vector2 pos, char look_for)
 {
-    Rectangle entity_hitbox = {pos.x, pos.y, 1.0f, 1.0f};
-
-    // Scan the adjacent area in the level to look for a match in collision
-    for (int row = pos.y - 1; row < pos.y + 1; ++row) {
-        for (int column = pos.x - 1; column < pos.x + 1; ++column) {
-            // Check if the cell is out-of-bounds
-            if (!LevelController::getInstanceLevel().is_inside_level(row, column)) continue;
-            if (Level::get_level_cell(row, column) == look_for) {
-                Rectangle block_hitbox = {(float) column, (float) row, 1.0f, 1.0f};
-                if (CheckCollisionRecs(entity_hitbox, block_hitbox)) {
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
-}
-
-// Retrieve reference to colliding cell
-char& LevelController::get_collider(Vector2 pos, char look_for) {
-    // Like is_colliding(), except returns a reference to the colliding object
-    Rectangle player_hitbox = {pos.x, pos.y, 1.0f, 1.0f};
-
-    for (int row = pos.y - 1; row < pos.y + 1; ++row) {
-        for (int column = pos.x - 1; column < pos.x + 1; ++column) {
-            // Check if the cell is out-of-bounds
-            if (!LevelController::getInstanceLevel().is_inside_level(row, column)) continue;
-            if (Level::get_level_cell(row, column) == look_for) {
-                Rectangle block_hitbox = {(float) column, (float) row, 1.0f, 1.0f};
-                if (CheckCollisionRecs(player_hitbox, block_hitbox)) {
-                    return Level::get_level_cell(row, column);
-                }
-            }
-        }
+    return query_tiles(pos).touches(look_for);
+}
+
+// Retrieve the colliding cell
+LevelCell LevelController::get_collider(Vector2 pos, char look_for) {
+    // Like is_colliding(), except returns the position of the colliding object
+    LevelCell cell;
+    if (query_tiles(pos).find(look_for, cell)) {
+        return cell;
     }
 
     // If failed, get an approximation
-    return Level::get_level_cell(pos.x, pos.y);
+    return {static_cast<size_t>(pos.y), static_cast<size_t>(pos.x)};
 }
 
 void LevelController::reset_level_index()
@@ -72,30 +64,31 @@ void LevelController::reset_level_index()
 
 void LevelController::load_level(int offset)
 {
+    TRACE_ZONE("load_level");
+    ++level_load_count;
+
+    // Endless levels have no exit, so loading one always restarts the run
+    if (endless) {
+        load_endless_level();
+        return;
+    }
+
     level_index += offset;
 
     // Win logic
-    if (level_index >= LEVEL_COUNT) {
+    if (level_index >= static_cast<int>(LEVELS.size())) {
         game_state = VICTORY_STATE;
         create_victory_menu_background();
         level_index = 0;
         return;
     }
 
-    // Level duplication
-    size_t rows = LEVELS[level_index].get_rows();
-    size_t columns = LEVELS[level_index].get_columns();
-    current_level_data = new char[rows * columns];
-
-    for (int row = 0; row < rows; row++) {
-        for (int column = 0; column < columns; column++) {
-            const char* source_data = LEVELS[level_index].get_data();
-            current_level_data[row * columns + column] = source_data[row * columns + column];
-        }
-    }
-    LevelController::getInstanceLevel().set_current_level(Level{rows, columns, current_level_data});
+    // Level duplication, unpacking the compressed template into the live grid
+    current_level.load_from(LEVELS[level_index]);
+    mark_level_changed();
 
-    // Instantiate entities
+    // Instantiate entities, moving colliders first so the others can stand on them
+    spawn_dynamic_colliders();
     Player::getInstancePlayer().spawn_player();
     EnemiesController::getInstance().spawn_enemies();
 
@@ -108,78 +101,345 @@ void LevelController::load_level(int offset)
 
 void LevelController::unload_level()
 {
-    delete[] LevelController::getInstanceLevel().get_current_level_data();
+    LevelController::getInstanceLevel().chunk_streamer.stop();
+    LevelController::getInstanceLevel().set_current_level(Level{});
+    LevelController::getInstanceLevel().dynamic_colliders.reset(0, 0);
 }
-void LevelController::draw_level()
+
+void LevelController::start_endless_mode(uint64_t seed)
 {
-    // Move the x-axis' center to the middle of the screen
-    horizontal_shift = (screen_size.x - cell_size) / 2;
+    endless = true;
+    endless_generator = LevelGenerator{seed};
+    level_index = 0;
+    load_endless_level();
+}
 
-    for (size_t row = 0; row < LevelController::getInstanceLevel().get_current_level().get_rows(); ++row) {
-        for (size_t column = 0; column < LevelController::getInstanceLevel().get_current_level().get_columns(); ++column) {
+void LevelController::stop_endless_mode()
+{
+    endless = false;
+    scrolled_columns = 0;
+    chunk_streamer.stop();
+}
 
-            Vector2 pos = {
-                // Move the level to the left as the player advances to the right,
-                // shifting to the left to allow the player to be centered later
-                (static_cast<float>(column) - Player::getInstancePlayer().get_player_posX()) * cell_size + horizontal_shift,
-                static_cast<float>(row) * cell_size
-        };
+bool LevelController::is_endless() const
+{
+    return endless;
+}
+
+long LevelController::get_scrolled_columns() const
+{
+    return scrolled_columns;
+}
 
-            // Draw the level itself
-            char cell = Level::get_level_cell(row, column);
-            switch (cell) {
-                case WALL:draw_image(wall_image, pos, cell_size); break;
-                case WALL_DARK:draw_image(wall_dark_image, pos, cell_size); break;
-                case SPIKE:draw_image(spike_image, pos, cell_size); break;
-                case COIN:draw_sprite(coin_sprite, pos, cell_size); break;
-                case EXIT:draw_image(exit_image, pos, cell_size); break;
-                default: break;
+void LevelController::save(snapshot &out) const
+{
+    if (endless) throw std::runtime_error("Endless levels cannot be saved");
+    // Most frames change no tiles, so the slot often holds this very level already
+    if (out.level_revision != level_revision) {
+        out.level = current_level;
+        out.level_revision = level_revision;
+
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t row = 0; row < current_level.get_rows(); ++row) {
+            for (size_t column = 0; column < current_level.get_columns(); ++column) {
+                hash = (hash ^ static_cast<unsigned char>(current_level.get_cell(row, column))) * 1099511628211ull;
             }
         }
+        out.tile_hash = hash;
+    }
+    out.colliders = dynamic_colliders;
+}
+
+void LevelController::restore(const snapshot &in)
+{
+    if (level_revision != in.level_revision) {
+        current_level = in.level;
+        level_revision = in.level_revision;
+    }
+    dynamic_colliders = in.colliders;
+}
+
+void LevelController::mark_level_changed()
+{
+    level_revision = ++revision_counter;
+}
+
+void LevelController::load_endless_level()
+{
+    // Every run of a seed starts over from its first chunk
+    chunk_streamer.stop();
+    scrolled_columns = 0;
+
+    // The first window is generated right away while loading; only the chunks after it are streamed
+    current_level = Level{LevelGenerator::ROWS, ENDLESS_WINDOW_CHUNKS * LevelGenerator::CHUNK_COLUMNS};
+    PackedTileGrid chunk{LevelGenerator::ROWS, LevelGenerator::CHUNK_COLUMNS};
+    for (uint64_t index = 0; index < ENDLESS_WINDOW_CHUNKS; ++index) {
+        endless_generator.generate(index, chunk);
+        current_level.scroll(chunk);
     }
+    mark_level_changed();
+    chunk_streamer.start(endless_generator, ENDLESS_WINDOW_CHUNKS);
 
-    Player::getInstancePlayer().draw_player();
+    spawn_dynamic_colliders();
+    Player::getInstancePlayer().spawn_player();
+    EnemiesController::getInstance().spawn_enemies();
+
+    // Room for as many entities as the window has cells, so scrolling new chunks in never allocates
+    const size_t window_cells = current_level.get_rows() * current_level.get_columns();
+    current_level.reserve_markers(window_cells);
+    dynamic_colliders.reserve(window_cells);
+    EnemiesController::getInstance().reserve(window_cells);
+
+    derive_graphics_metrics_from_loaded_level();
+    timer = MAX_LEVEL_TIME;
+}
+
+void LevelController::update_endless_level()
+{
+    if (!endless) return;
+
+    // Scroll a chunk once the player is a chunk past the middle of the window. If the worker
+    // has not finished the next one yet, try again next frame: there is still plenty ahead.
+    const float threshold = static_cast<float>(current_level.get_columns() / 2 + LevelGenerator::CHUNK_COLUMNS);
+    if (Player::getInstancePlayer().get_player_posX() < threshold) return;
+
+    const PackedTileGrid *chunk = chunk_streamer.peek();
+    if (chunk == nullptr) return;
+    scroll_endless_level(*chunk);
+    chunk_streamer.pop();
+}
+
+void LevelController::scroll_endless_level(const PackedTileGrid &chunk)
+{
+    const long columns = static_cast<long>(chunk.get_columns());
+    current_level.scroll(chunk);
+    mark_level_changed();
+    scrolled_columns += columns;
+
+    // Everything in the level moves left along with it, then the new chunk's entities spawn,
+    // moving colliders first so the enemies' patrols know about them
+    const size_t first_new = current_level.get_columns() - chunk.get_columns();
+    const size_t last_new = current_level.get_columns() - 1;
+    Player &player = Player::getInstancePlayer();
+    int32_t ground = player.get_ground_collider();
+    dynamic_colliders.shift_origin(columns, ground);
+    spawn_dynamic_colliders_in(first_new, last_new);
+    player.set_ground_collider(ground);
+    player.set_player_posX(player.get_player_posX() - static_cast<float>(columns));
+
+    EnemiesController::getInstance().shift_origin(columns);
+    EnemiesController::getInstance().spawn_enemies_in(first_new, last_new);
+}
+
+void LevelController::spawn_dynamic_colliders()
+{
+    dynamic_colliders.reset(current_level.get_rows(), current_level.get_columns());
+    spawn_dynamic_colliders_in(0, current_level.get_columns() - 1);
+}
+
+void LevelController::spawn_dynamic_colliders_in(size_t first_column, size_t last_column)
+{
+    current_level.get_bitplanes().for_each<DYNAMIC_TRAIT>(0, current_level.get_rows() - 1, first_column, last_column, [&](size_t row, size_t column, uint8_t kind) {
+        dynamic_colliders.spawn(kind, row, column, current_level.get_bitplanes());
+        set_level_cell(row, column, AIR);
+    });
+}
+
+void LevelController::update_dynamic_colliders()
+{
+    dynamic_colliders.update(current_level.get_bitplanes());
+}
+
+// Textures of the tile kinds that have IMAGE_TRAIT or SPRITE_TRAIT
+static Texture2D* const TILE_IMAGES[TILE_KIND_COUNT] = {
+    nullptr, &wall_image, &wall_dark_image, &spike_image, nullptr, nullptr, nullptr, &exit_image,
+    &wall_image, &wall_image, &spike_image, nullptr
+};
+static sprite* const TILE_SPRITES[TILE_KIND_COUNT] = {
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, &coin_sprite, nullptr,
+    nullptr, nullptr, nullptr, nullptr
+};
+
+void LevelController::draw_level()
+{
+    TRACE_ZONE("draw_level");
+
+    // Move the x-axis' center to the middle of the screen
+    horizontal_shift = (screen_size.x - cell_size) / 2;
+
+    // Only the columns that end up on screen are visited
+    float player_x = Player::getInstancePlayer().get_player_posX(local_player);
+    float first_visible = std::floor(player_x - (horizontal_shift + cell_size) / cell_size);
+    float last_visible = std::ceil(player_x + (screen_size.x - horizontal_shift) / cell_size);
+    size_t first_column = first_visible > 0 ? static_cast<size_t>(first_visible) : 0;
+    size_t last_column = last_visible > 0 ? static_cast<size_t>(last_visible) : 0;
+    size_t last_row = current_level.get_rows() > 0 ? current_level.get_rows() - 1 : 0;
+
+    auto cell_position = [&](size_t row, size_t column) {
+        return Vector2 {
+            // Move the level to the left as the player advances to the right,
+            // shifting to the left to allow the player to be centered later
+            (static_cast<float>(column) - player_x) * cell_size + horizontal_shift,
+            static_cast<float>(row) * cell_size
+        };
+    };
+
+    // Draw the level itself, one pass per way of drawing a tile
+    const TileBitplanes &bitplanes = current_level.get_bitplanes();
+    bitplanes.for_each<IMAGE_TRAIT>(0, last_row, first_column, last_column, [&](size_t row, size_t column, uint8_t kind) {
+        draw_image(*TILE_IMAGES[kind], cell_position(row, column), cell_size);
+        ++current_frame_counters.tiles_drawn;
+    });
+    // Animated tiles keep no state: the game clock plus a phase from the cell, counted from where
+    // the level started so scrolling an endless level keeps every coin on its frame
+    bitplanes.for_each<SPRITE_TRAIT>(0, last_row, first_column, last_column, [&](size_t row, size_t column, uint8_t kind) {
+        const uint32_t cell = static_cast<uint32_t>(row << 16 | (column + static_cast<size_t>(scrolled_columns)));
+        const size_t frame = sprite_frame(*TILE_SPRITES[kind], game_frame + animation_phase(cell));
+        draw_sprite(*TILE_SPRITES[kind], frame, cell_position(row, column), cell_size);
+        ++current_frame_counters.tiles_drawn;
+    });
+    size_t visible_columns = std::min(last_column + 1, current_level.get_columns()) - std::min(first_column, current_level.get_columns());
+    current_frame_counters.tiles_visited += visible_columns * current_level.get_rows();
+
+    // Moving colliders, which sit between cells
+    dynamic_colliders.for_each_in_range(first_visible - 1.0f, last_visible, [&](const DynamicCollider &collider) {
+        Vector2 pos = {
+            (collider.position.x - player_x) * cell_size + horizontal_shift,
+            collider.position.y * cell_size
+        };
+        draw_image(*TILE_IMAGES[collider.kind], pos, cell_size);
+    });
+
+    Player::getInstancePlayer().draw_players();
     EnemiesController::getInstance().draw_enemies();
 }
 // Getters and setters
-char& Level::get_level_cell(size_t row, size_t column) {
-    return LevelController::getInstanceLevel().get_current_level().data[row * LevelController::getInstanceLevel().get_current_level().get_columns() + column];
+char Level::get_level_cell(size_t row, size_t column) {
+    return LevelController::getInstanceLevel().get_current_level().tiles.get(row, column);
 }
 
 void LevelController::set_level_cell(size_t row,size_t column, char chr) {
-    Level::get_level_cell(row, column) = chr;
+    // Chasers route around solid tiles, so tell them when one appears or disappears
+    bool was_solid = tile_has_traits<SOLID_TRAIT>(current_level.get_cell(row, column));
+    current_level.set_cell(row, column, chr);
+    mark_level_changed();
+    if (was_solid != tile_has_traits<SOLID_TRAIT>(chr)) {
+        EnemiesController::getInstance().invalidate_navigation(row, column);
+    }
 }
 
 void LevelController::set_current_level(const Level &current_level) {
     this->current_level = current_level;
+    mark_level_changed();
 }
 
-std::vector<Level> LevelController::loadLevelsFromFile(const std::string& filename) {
+std::vector<CompressedTileGrid> LevelController::loadLevelsFromFile(const std::string& filename) {
+    TRACE_ZONE("loadLevelsFromFile");
     std::ifstream file(filename);
     if (!file.is_open()) throw("Could not open file: " + filename);
 
+    // Loading again replaces the levels instead of adding to them
+    LEVELS.clear();
+    level_lines.clear();
+
     std::string line;
     while (std::getline(file, line)) {
         if (!line.empty() && line[0] != ';') {
             LEVELS.push_back(parseLevelRLE(line));
+            level_lines.push_back(line);
         }
     }
 
     if (LEVELS.empty()) throw("No valid levels found in file");
+    player_level_scores.assign(LEVELS.size(), 0);
     return LEVELS;
 }
 
-Level LevelController::parseLevelRLE(const std::string& rleData) {
-    std::vector<std::string> rows;
-    std::string rowBuf, countBuf;
+bool LevelController::reloadLevelsFromFile(const std::string& filename) {
+    TRACE_ZONE("reloadLevelsFromFile");
+    std::ifstream file(filename);
+    if (!file.is_open()) throw std::runtime_error("Could not open file: " + filename);
+
+    // Everything is parsed before anything is replaced, so a half-finished edit changes nothing
+    std::vector<std::string> lines;
+    std::vector<std::pair<size_t, CompressedTileGrid>> edited;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == ';') continue;
+
+        const size_t index = lines.size();
+        lines.push_back(line);
+        // Whole lines are compared, so no edit can pass for an unchanged line
+        if (index < level_lines.size() && level_lines[index] == line) continue;
+        try {
+            edited.emplace_back(index, parseLevelRLE(line));
+        } catch (const std::exception &error) {
+            throw std::runtime_error("Level " + std::to_string(index + 1) + ": " + error.what());
+        }
+    }
+    if (lines.empty()) throw std::runtime_error("No valid levels found in file");
+
+    // When the level in play was deleted, play goes on in what is now the last level
+    level_in_play_removed = level_index >= static_cast<int>(lines.size());
+    if (level_in_play_removed) level_index = static_cast<int>(lines.size()) - 1;
+    bool current_changed = level_in_play_removed;
+    LEVELS.resize(lines.size());
+    for (auto &[index, level] : edited) {
+        current_changed = current_changed || static_cast<int>(index) == level_index;
+        LEVELS[index] = std::move(level);
+    }
+    level_lines = std::move(lines);
+    player_level_scores.resize(LEVELS.size(), 0);
+    return current_changed;
+}
+
+void LevelController::reload_current_level() {
+    TRACE_ZONE("reload_current_level");
+    Player &player = Player::getInstancePlayer();
+    const PlayerArchetype before = player.get_players();
+    const int time_left = timer;
+
+    load_level(0);
+    // Every coin is back in the level, so the ones already taken are no longer counted
+    player_level_scores[level_index] = 0;
+    // The players' places belonged to the deleted level, so they start this one from its spawn
+    if (level_in_play_removed) return;
+
+    PlayerArchetype after = player.get_players();
+    const float last_column = static_cast<float>(current_level.get_columns()) - 1.0f;
+    const float last_row = static_cast<float>(current_level.get_rows()) - 1.0f;
+    for (size_t i = 0; i < std::min(before.size(), after.size()); ++i) {
+        const Vector2 position = before.get<Position>(i).value;
+        if (position.x < 0.0f || position.x > last_column || position.y > last_row) continue;
+        if (is_colliding_with<SOLID_TRAIT>(position)) continue;
+
+        // Whatever was underfoot got spawned again, so the next gravity step finds the ground anew
+        after.get<Position>(i) = before.get<Position>(i);
+        after.get<Velocity>(i) = before.get<Velocity>(i);
+        after.get<GroundContact>(i) = {false, -1};
+        after.get<Facing>(i) = before.get<Facing>(i);
+        after.get<Animation>(i) = before.get<Animation>(i);
+    }
+    player.set_players(after);
+    timer = time_left;
+}
+
+CompressedTileGrid LevelController::parseLevelRLE(const std::string& rleData) {
+    // Runs go straight into the compressed grid, so even huge levels are never expanded here
+    CompressedTileGrid level;
+    std::string countBuf;
+
+    auto end_row = [&]() {
+        if (level.get_rows() > 0 && level.get_pending_row_length() != level.get_columns())
+            throw std::runtime_error("Row size mismatch");
+        level.end_row();
+        countBuf.clear();
+    };
 
     for (char c : rleData) {
         if (c == '|') {
-            rows.push_back(rowBuf);
-            rowBuf.clear();
-            countBuf.clear();
+            end_row();
         } else if (c == ';') {
-            if (!rowBuf.empty()) rows.push_back(rowBuf);
             break;
         } else if (isdigit(c)) {
             countBuf += c;
@@ -187,33 +447,22 @@ Level LevelController::parseLevelRLE(const std::string& rleData) {
             int count = countBuf.empty() ? 1 : std::stoi(countBuf);
             countBuf.clear();
 
-            if (std::string("#=-@*^&E").find(c) == std::string::npos)
+            if (!is_tile_char(c))
                 throw std::runtime_error("Invalid character: " + std::string(1, c));
 
-            rowBuf.append(count, c);
+            level.append_run(c, count);
         }
     }
 
-    if (!rowBuf.empty()) rows.push_back(rowBuf);
-    if (rows.empty()) throw std::runtime_error("No rows parsed");
-
-    size_t width = rows[0].size();
-    for (const auto& r : rows) {
-        if (r.size() != width) throw std::runtime_error("Row size mismatch");
-    }
-
-    size_t height = rows.size();
-    char* data = new char[height * width];
-    for (size_t r = 0; r < height; ++r)
-        for (size_t c = 0; c < width; ++c)
-            data[r * width + c] = rows[r][c];
+    if (level.get_pending_row_length() > 0) end_row();
+    if (level.get_rows() == 0) throw std::runtime_error("No rows parsed");
 
-    return { height, width, data };
+    return level;
 }
 
 
 
-std::vector<Level> LevelController::get_levels() const {
+const std::vector<CompressedTileGrid>& LevelController::get_levels() const {
     return LEVELS;
 }
 
@@ -221,6 +470,6 @@ Level& LevelController::get_current_level() {
     return current_level;
 }
 
-char* LevelController::get_current_level_data() const {
-    return current_level_data;
+DynamicColliders& LevelController::get_dynamic_colliders() {
+    return dynamic_colliders;
 }
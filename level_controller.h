@@ -2,7 +2,13 @@
 #define LEVEL_CONTROLLER_H
 
 #include "level.h"
+#include "tile_grid.h"
+#include "tile_bitplanes.h"
+#include "dynamic_colliders.h"
+#include "level_generator.h"
+#include "chunk_streamer.h"
 #include "raylib.h"
+#include "globals.h"
 #include <vector>
 #include <string>
 
@@ -18,36 +24,105 @@ public:
     LevelController& operator=(LevelController&&) = delete;
 
     // Accessors and modifiers
-    [[nodiscard]] std::vector<Level> get_levels() const;
-    void set_levels(const std::vector<Level>& level_list);
+    [[nodiscard]] const std::vector<CompressedTileGrid>& get_levels() const;
 
     [[nodiscard]] Level& get_current_level();
-    [[nodiscard]] char* get_current_level_data() const;
+    [[nodiscard]] DynamicColliders& get_dynamic_colliders();
 
     void set_current_level(const Level& level);
     void set_level_cell(size_t row_index, size_t column_index, char new_value);
 
-    // Core game logic
+    // Core game logic; the collision queries cover tiles and moving colliders alike
     bool is_inside_level(int row_index, int column_index);
+    [[nodiscard]] TileContacts query_tiles(Vector2 position) const;
+    template <uint8_t Traits>
+    [[nodiscard]] bool is_colliding_with(Vector2 position) const;
+    template <uint8_t Traits>
+    [[nodiscard]] SweepResult sweep(Vector2 position, Vector2 delta) const;
     bool is_colliding(Vector2 position, char target);
-    char& get_collider(Vector2 position, char target);
+    LevelCell get_collider(Vector2 position, char target);
 
     void draw_level();
     void load_level(int level_offset = 0);
     static void unload_level();
+    void spawn_dynamic_colliders();
+    void update_dynamic_colliders();
     static void reset_level_index();
 
+    // Endless mode: the level is a window of generated chunks that scrolls left as the player
+    // moves right, so memory and per-frame work stay the same however far they go
+    void start_endless_mode(uint64_t seed);
+    void stop_endless_mode();
+    void update_endless_level();
+    [[nodiscard]] bool is_endless() const;
+    // Columns scrolled off the left of the window so far
+    [[nodiscard]] long get_scrolled_columns() const;
+
+    // The level as gameplay changed it so far, for rollback. Endless levels stream in on
+    // another thread and cannot be rolled back.
+    struct snapshot {
+        Level level;
+        uint64_t level_revision = 0;
+        uint64_t tile_hash = 0; // FNV-1a of the level's tiles, for checksums, made along with the copy
+        DynamicColliders colliders;
+    };
+
+    void save(snapshot &out) const;
+    void restore(const snapshot &in);
+
     // Level parsing
-    Level parseLevelRLE(const std::string& encoded_data);
-    std::vector<Level> loadLevelsFromFile(const std::string& filepath);
+    CompressedTileGrid parseLevelRLE(const std::string& encoded_data);
+    std::vector<CompressedTileGrid> loadLevelsFromFile(const std::string& filepath);
+    // Reads the file again but only parses the levels whose line changed, and returns whether the
+    // level in play was one of them. A bad edit leaves every level as it was and throws
+    // std::runtime_error saying what is wrong.
+    bool reloadLevelsFromFile(const std::string& filepath);
+    // Swaps in the new version of the level in play, keeping the players where they are unless
+    // the edit put something solid there. If the level was deleted, the last level starts over.
+    void reload_current_level();
 
 private:
     LevelController() = default;
     ~LevelController() = default;
 
+    // Chunks in the endless window; the player is kept around its middle
+    static constexpr size_t ENDLESS_WINDOW_CHUNKS = 8;
+
+    void load_endless_level();
+    void scroll_endless_level(const PackedTileGrid &chunk);
+    void spawn_dynamic_colliders_in(size_t first_column, size_t last_column);
+    void mark_level_changed();
+
     Level current_level;
-    char* current_level_data = nullptr;
-    std::vector<Level> LEVELS;
+    // Changes with every edit of current_level and never goes back to an earlier value, so equal
+    // revisions mean equal levels and snapshots can skip copying one they already hold
+    uint64_t level_revision = 0;
+    uint64_t revision_counter = 0;
+    DynamicColliders dynamic_colliders;
+    std::vector<CompressedTileGrid> LEVELS;
+    std::vector<std::string> level_lines; // Every level's line in the file, to find the edited ones
+    bool level_in_play_removed = false; // By the last reload
+
+    bool endless = false;
+    long scrolled_columns = 0;
+    LevelGenerator endless_generator;
+    ChunkStreamer chunk_streamer;
 };
 
+// --- Inline Definitions ---
+
+template <uint8_t Traits>
+inline bool LevelController::is_colliding_with(Vector2 pos) const {
+    ++current_frame_counters.collision_queries;
+    return current_level.get_bitplanes().overlaps<Traits>(pos) || dynamic_colliders.overlaps<Traits>(pos);
+}
+
+template <uint8_t Traits>
+inline SweepResult LevelController::sweep(Vector2 pos, Vector2 delta) const {
+    ++current_frame_counters.collision_queries;
+    SweepResult result = current_level.get_bitplanes().sweep<Traits>(pos, delta);
+    dynamic_colliders.sweep<Traits>(pos, delta, result);
+    return result;
+}
+
 #endif // LEVEL_CONTROLLER_H
@@ -0,0 +1,165 @@
+#include "level_generator.h"
+#include "split_mix.h"
+#include <algorithm>
+
+namespace {
+
+// Ground heights, counted in tiles from the bottom row
+const int BASE_HEIGHT = 3;
+const int MIN_HEIGHT = 2;
+const int MAX_HEIGHT = 5;
+
+// Columns of flat ground at the base height at both ends of every chunk
+const size_t CHUNK_EDGE = 2;
+// The player spawns on flat ground with this many quiet columns around them
+const size_t SPAWN_COLUMN = 2;
+const size_t SPAWN_COLUMNS = 8;
+
+enum chunk_feature {
+    FLAT_FEATURE,
+    STEP_FEATURE,
+    PIT_FEATURE,
+    SPIKES_FEATURE,
+    ARENA_FEATURE,
+    PLATFORM_PIT_FEATURE,
+    FALLING_BRIDGE_FEATURE,
+    SPIKE_SHAFT_FEATURE,
+    CHASER_FEATURE
+};
+
+// Out of 16, how often each feature comes up
+const chunk_feature FEATURE_TABLE[16] = {
+    FLAT_FEATURE, FLAT_FEATURE, FLAT_FEATURE, FLAT_FEATURE,
+    STEP_FEATURE, STEP_FEATURE,
+    PIT_FEATURE, PIT_FEATURE,
+    SPIKES_FEATURE, SPIKES_FEATURE,
+    ARENA_FEATURE, ARENA_FEATURE,
+    PLATFORM_PIT_FEATURE,
+    FALLING_BRIDGE_FEATURE,
+    SPIKE_SHAFT_FEATURE,
+    CHASER_FEATURE
+};
+
+}
+
+LevelGenerator::LevelGenerator(uint64_t seed)
+    : seed(seed) {}
+
+uint64_t LevelGenerator::get_seed() const {
+    return seed;
+}
+
+void LevelGenerator::generate(uint64_t chunk_index, PackedTileGrid &chunk) const {
+    const size_t rows = chunk.get_rows();
+    for (size_t row = 0; row < rows; ++row) {
+        chunk.fill_run(row, 0, CHUNK_COLUMNS, AIR);
+    }
+
+    // Seeded from the level seed and the chunk index, so a chunk does not depend on the ones before
+    SplitMix64 random(seed ^ (chunk_index * SplitMix64::GOLDEN_GAMMA));
+    int height = BASE_HEIGHT;
+
+    // The row of the top ground tile, and the row entities stand on
+    auto surface = [&]() { return rows - static_cast<size_t>(height); };
+    auto ground = [&](size_t column) {
+        for (size_t row = surface(); row < rows; ++row) chunk.set(row, column, WALL);
+    };
+
+    size_t column = 0;
+    const size_t first_feature = chunk_index == 0 ? SPAWN_COLUMNS : CHUNK_EDGE;
+    for (; column < first_feature; ++column) ground(column);
+    if (chunk_index == 0) chunk.set(surface() - 1, SPAWN_COLUMN, PLAYER);
+
+    // Features never reach into the flat columns at the end of the chunk
+    const size_t last_feature = CHUNK_COLUMNS - CHUNK_EDGE;
+    bool has_chaser = false;
+    while (column < last_feature) {
+        const size_t room = last_feature - column;
+        chunk_feature feature = FEATURE_TABLE[random.next() % 16];
+
+        // Gaps and hazards are followed by a column of ground at the same height to land on
+        switch (feature) {
+            case STEP_FEATURE: {
+                height = std::clamp(height + random.between(-2, 2), MIN_HEIGHT, MAX_HEIGHT);
+                size_t width = std::min<size_t>(2, room);
+                for (size_t i = 0; i < width; ++i) ground(column++);
+                break;
+            }
+            case PIT_FEATURE: {
+                size_t width = static_cast<size_t>(random.between(2, 3));
+                if (width + 1 > room) break;
+                column += width;
+                ground(column++);
+                break;
+            }
+            case SPIKES_FEATURE: {
+                size_t width = static_cast<size_t>(random.between(1, 2));
+                if (width + 1 > room) break;
+                for (size_t i = 0; i < width; ++i) {
+                    ground(column);
+                    chunk.set(surface() - 1, column++, SPIKE);
+                }
+                ground(column++);
+                break;
+            }
+            case ARENA_FEATURE: {
+                // An enemy pacing between two low pillars
+                size_t width = static_cast<size_t>(random.between(7, 9));
+                if (width > room) break;
+                for (size_t i = 0; i < width; ++i) ground(column + i);
+                chunk.set(surface() - 1, column, WALL);
+                chunk.set(surface() - 1, column + width - 1, WALL);
+                chunk.set(surface() - 1, column + width / 2, ENEMY);
+                column += width;
+                break;
+            }
+            case PLATFORM_PIT_FEATURE: {
+                // Too wide to jump, with a platform pacing between its edges
+                size_t width = static_cast<size_t>(random.between(5, 6));
+                if (width + 1 > room) break;
+                chunk.set(surface(), column, MOVING_PLATFORM);
+                column += width;
+                ground(column++);
+                break;
+            }
+            case FALLING_BRIDGE_FEATURE: {
+                size_t width = static_cast<size_t>(random.between(3, 4));
+                if (width + 1 > room) break;
+                for (size_t i = 0; i < width; ++i) chunk.set(surface(), column++, FALLING_BLOCK);
+                ground(column++);
+                break;
+            }
+            case SPIKE_SHAFT_FEATURE: {
+                // A spike bobbing between the ground and a block overhead
+                if (room < 2) break;
+                ground(column);
+                chunk.set(surface() - 1, column, MOVING_SPIKE);
+                chunk.set(surface() - 4, column++, WALL);
+                ground(column++);
+                break;
+            }
+            case CHASER_FEATURE: {
+                // Chasers are rare and never show up right next to the spawn
+                if (chunk_index < 2 || has_chaser || room < 3) break;
+                for (size_t i = 0; i < 3; ++i) ground(column + i);
+                chunk.set(1, column + 1, CHASER);
+                column += 3;
+                has_chaser = true;
+                break;
+            }
+            case FLAT_FEATURE: {
+                size_t width = std::min<size_t>(static_cast<size_t>(random.between(2, 4)), room);
+                bool coins = random.next() & 1;
+                for (size_t i = 0; i < width; ++i) {
+                    ground(column);
+                    if (coins) chunk.set(surface() - 2, column, COIN);
+                    ++column;
+                }
+                break;
+            }
+        }
+    }
+
+    height = BASE_HEIGHT;
+    for (; column < CHUNK_COLUMNS; ++column) ground(column);
+}
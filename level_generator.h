@@ -0,0 +1,29 @@
+#ifndef LEVEL_GENERATOR_H
+#define LEVEL_GENERATOR_H
+
+#include "tile_grid.h"
+#include <cstddef>
+#include <cstdint>
+
+// Builds endless levels one chunk of columns at a time. A chunk only depends on the seed
+// and its index, so any chunk can be regenerated on any thread and comes out the same.
+// Every chunk starts and ends on flat ground at the base height, so chunks join seamlessly,
+// and every feature fits inside its chunk, so enemies and platforms never pace across one.
+class LevelGenerator {
+public:
+    static constexpr size_t CHUNK_COLUMNS = 32;
+    static constexpr size_t ROWS = 12;
+
+    LevelGenerator() = default;
+    explicit LevelGenerator(uint64_t seed);
+
+    [[nodiscard]] uint64_t get_seed() const;
+
+    // Overwrites the chunk, which must already be ROWS x CHUNK_COLUMNS; chunk 0 holds the player
+    void generate(uint64_t chunk_index, PackedTileGrid &chunk) const;
+
+private:
+    uint64_t seed = 0;
+};
+
+#endif // LEVEL_GENERATOR_H
@@ -5,89 +5,26 @@
 #include "assets.h"
 #include "enemies_controller.h"
 #include "level_controller.h"
-
-void update_game() {
-    game_frame++;
-
-    switch (game_state) {
-        case MENU_STATE:
-            if (IsKeyPressed(KEY_ENTER)) {
-                SetExitKey(0);
-                game_state = GAME_STATE;
-                LevelController::getInstanceLevel().load_level(0);
-            }
-            break;
-
-        case GAME_STATE:
-            if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D)) {
-                Player::getInstancePlayer().move_player_horizontally(PLAYER_MOVEMENT_SPEED);
-            }
-
-            if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A)) {
-                Player::getInstancePlayer().move_player_horizontally(-PLAYER_MOVEMENT_SPEED);
-            }
-
-            // Calculating collisions to decide whether the player is allowed to jump
-        Player::getInstancePlayer().set_is_player_on_ground(
-            LevelController::getInstanceLevel().is_colliding(
-                {Player::getInstancePlayer().get_player_posX(), Player::getInstancePlayer().get_player_posY() + 0.1f},
-                WALL
-                )
-                );
-        if ((IsKeyDown(KEY_UP) || IsKeyDown(KEY_W) || IsKeyDown(KEY_SPACE)) && Player::getInstancePlayer().is_player_on_ground()) {
-                player_y_velocity = -JUMP_STRENGTH;
-            }
-
-            Player::getInstancePlayer().update_player();
-            EnemiesController::getInstance().update_enemies();
-
-            if (IsKeyPressed(KEY_ESCAPE)) {
-                game_state = PAUSED_STATE;
-            }
-            break;
-
-        case PAUSED_STATE:
-            if (IsKeyPressed(KEY_ESCAPE)) {
-                game_state = GAME_STATE;
-            }
-            break;
-
-        case DEATH_STATE:
-            Player::getInstancePlayer().update_player_gravity();
-
-            if (IsKeyPressed(KEY_ENTER)) {
-                if (player_lives > 0) {
-                    LevelController::getInstanceLevel().load_level(0);
-                    game_state = GAME_STATE;
-                }
-                else {
-                    game_state = GAME_OVER_STATE;
-                    PlaySound(game_over_sound);
-                }
-            }
-            break;
-
-        case GAME_OVER_STATE:
-            if (IsKeyPressed(KEY_ENTER)) {
-                LevelController::getInstanceLevel().reset_level_index();
-                Player::getInstancePlayer().reset_player_stats();
-                game_state = GAME_STATE;
-                LevelController::getInstanceLevel().load_level();
-            }
-            break;
-
-        case VICTORY_STATE:
-            if (IsKeyPressed(KEY_ENTER) || IsKeyPressed(KEY_ESCAPE)) {
-                LevelController::getInstanceLevel().reset_level_index();
-                Player::getInstancePlayer().reset_player_stats();
-                game_state = MENU_STATE;
-                SetExitKey(KEY_ESCAPE);
-            }
-            break;
-    }
-}
+#include "audio_thread.h"
+#include "trace.h"
+#include "heap_counter.h"
+#include "frame_telemetry.h"
+#include "frame_capture.h"
+#include "file_watcher.h"
+#include "input.h"
+#include "input_latency.h"
+#include "game.h"
+#include "rollback.h"
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
 
 void draw_game() {
+    TRACE_ZONE("draw_game");
+
     switch(game_state) {
         case MENU_STATE:
             ClearBackground(BLACK);
@@ -99,6 +36,9 @@ void draw_game() {
             draw_parallax_background();
             LevelController::getInstanceLevel().draw_level();
             draw_game_overlay();
+            if (performance_hud_visible) {
+                draw_performance_hud();
+            }
             break;
 
         case DEATH_STATE:
@@ -122,27 +62,297 @@ void draw_game() {
     }
 }
 
-int main() {
-    SetConfigFlags(FLAG_VSYNC_HINT);
+// Set by the signal handlers and acted on by the main loop, which can safely write files
+volatile std::sig_atomic_t telemetry_write_requested = 0;
+volatile std::sig_atomic_t exit_requested = 0;
+
+void request_telemetry_write(int) {
+    telemetry_write_requested = 1;
+}
+
+void request_exit(int) {
+    exit_requested = 1;
+}
+
+void write_telemetry() {
+    if (FrameTelemetry::getInstance().write("telemetry.bin")) {
+        TraceLog(LOG_INFO, "TELEMETRY: Wrote telemetry.bin, %llu stutters so far",
+                 static_cast<unsigned long long>(FrameTelemetry::getInstance().get_stutter_count()));
+    } else {
+        TraceLog(LOG_WARNING, "TELEMETRY: Could not write telemetry.bin");
+    }
+}
+
+void write_latency(const InputLatency &latency, const char *mode) {
+    const latency_summary summary = latency.summarize();
+    TraceLog(LOG_INFO, "LATENCY: %s, %zu edges: median %.1f ms, p95 %.1f ms, p99 %.1f ms, max %.1f ms", mode,
+             summary.count, summary.median_ms, summary.p95_ms, summary.p99_ms, summary.max_ms);
+    if (!latency.write_csv("latency.csv", mode)) {
+        TraceLog(LOG_WARNING, "LATENCY: Could not write latency.csv");
+    }
+}
+
+const char *LEVELS_PATH = "data/levels.rll";
+
+// Picks up an edit of the levels file; the level in play is swapped for its new version right away
+void reload_levels() {
+    const auto start = std::chrono::steady_clock::now();
+    LevelController &levels = LevelController::getInstanceLevel();
+    try {
+        const bool in_play = (game_state == GAME_STATE || game_state == PAUSED_STATE) && !levels.is_endless();
+        const bool swapped = levels.reloadLevelsFromFile(LEVELS_PATH) && in_play;
+        if (swapped) levels.reload_current_level();
+
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        TraceLog(LOG_INFO, "LEVELS: Reloaded %s in %.1f ms%s", LEVELS_PATH, ms, swapped ? ", level in play swapped in" : "");
+    } catch (const std::exception &error) {
+        TraceLog(LOG_WARNING, "LEVELS: Kept the previous levels, %s", error.what());
+    }
+}
+
+#ifdef PLATFORMER_ZERO_ALLOCATION_CHECK
+// Stops the game on the first frame of play that allocates once the level has warmed up,
+// saving a trace first when zones are compiled in so the allocating zone can be found
+void check_frame_allocations(size_t allocations) {
+    static size_t steady_frames = 0;
+    static size_t seen_level_loads = 0;
+
+    if (game_state != GAME_STATE || level_load_count != seen_level_loads) {
+        steady_frames = 0;
+        seen_level_loads = level_load_count;
+        return;
+    }
+    if (++steady_frames <= ZERO_ALLOCATION_WARMUP_FRAMES || allocations == 0) return;
+
+#ifdef PLATFORMER_TRACE
+    TraceRecorder::getInstance().write_chrome_trace("trace.json", 1.0);
+#endif
+    TraceLog(LOG_FATAL, "ALLOCATIONS: Frame %zu made %zu heap allocations during play", game_frame, allocations);
+}
+#endif
+
+struct launch_options {
+    std::string record_input;
+    std::string replay_input;
+    std::string capture_directory;
+    uint64_t capture_interval = 60;
+    bool hidden = false;
+    bool late_latch = false;
+    bool latency = false;
+    uint16_t host_port = 0;
+    std::string join_address; // HOST:PORT
+};
+
+const char *LAUNCH_USAGE =
+    "Usage: platformer [options]\n"
+    "  --record-input FILE    write the input of every frame to FILE\n"
+    "  --replay-input FILE    play the input in FILE instead of the keyboard, as fast as possible, then exit\n"
+    "  --capture DIR          save frames as PNGs to DIR\n"
+    "  --capture-interval N   save every Nth frame (default 60)\n"
+    "  --hidden               keep the window hidden\n"
+    "  --late-latch           sample the input as late as the frame allows\n"
+    "  --latency              measure input-to-present latency, written to latency.csv on exit\n"
+    "  --host PORT            play co-op with whoever joins on the UDP port\n"
+    "  --join HOST:PORT       play co-op with the game hosting at HOST:PORT\n";
+
+launch_options parse_launch_options(int argc, char **argv) {
+    launch_options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::runtime_error("Missing value for " + argument);
+            return argv[++i];
+        };
+
+        if (argument == "--record-input") options.record_input = value();
+        else if (argument == "--replay-input") options.replay_input = value();
+        else if (argument == "--capture") options.capture_directory = value();
+        else if (argument == "--capture-interval") options.capture_interval = std::stoull(value());
+        else if (argument == "--hidden") options.hidden = true;
+        else if (argument == "--late-latch") options.late_latch = true;
+        else if (argument == "--latency") options.latency = true;
+        else if (argument == "--host") options.host_port = static_cast<uint16_t>(std::stoul(value()));
+        else if (argument == "--join") options.join_address = value();
+        else throw std::runtime_error("Unknown option: " + argument);
+    }
+    if (options.host_port != 0 && !options.join_address.empty()) {
+        throw std::runtime_error("Either host or join, not both");
+    }
+    return options;
+}
+
+std::unique_ptr<InputTransport> open_transport(const launch_options &options) {
+    if (options.host_port != 0) return std::make_unique<UdpTransport>(options.host_port);
+
+    const size_t colon = options.join_address.rfind(':');
+    if (colon == std::string::npos) throw std::runtime_error("Expected HOST:PORT, got " + options.join_address);
+    return std::make_unique<UdpTransport>(options.join_address.substr(0, colon),
+                                          static_cast<uint16_t>(std::stoul(options.join_address.substr(colon + 1))));
+}
+
+int main(int argc, char **argv) {
+    launch_options options;
+    InputReplay input;
+    std::unique_ptr<InputTransport> transport;
+    try {
+        options = parse_launch_options(argc, argv);
+        if (!options.replay_input.empty()) input.start_replaying(options.replay_input);
+        if (!options.record_input.empty()) input.start_recording(options.record_input);
+        if (options.host_port != 0 || !options.join_address.empty()) transport = open_transport(options);
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << '\n' << LAUNCH_USAGE;
+        return 1;
+    }
+
+    // The game advances one step per frame, so a replay gives the same frames at any frame rate
+    unsigned int flags = input.is_replaying() ? 0 : FLAG_VSYNC_HINT;
+    if (options.hidden) flags |= FLAG_WINDOW_HIDDEN;
+    SetConfigFlags(flags);
     InitWindow(2048, 1024, "Platformer");
-    SetTargetFPS(60);
+    SetTargetFPS(input.is_replaying() ? 0 : TARGET_FPS);
     HideCursor();
+    TRACE_THREAD_NAME("main");
 
     load_fonts();
     load_images();
     load_sounds();
-    LevelController::getInstanceLevel().loadLevelsFromFile("data/levels.rll");
+    LevelController::getInstanceLevel().loadLevelsFromFile(LEVELS_PATH);
+
+    // Both sides of a network game start the first level at once and only exchange input from there
+    std::unique_ptr<RollbackSession> session;
+    if (transport) {
+        player_count = 2;
+        local_player = options.host_port != 0 ? 0 : 1;
+        session = std::make_unique<RollbackSession>(*transport, local_player);
+        SetExitKey(0);
+        game_state = GAME_STATE;
+    }
     LevelController::getInstanceLevel().load_level();
 
-    while (!WindowShouldClose()) {
-        BeginDrawing();
+    // Edits of the levels file show up while playing, except where the same levels have to be played
+    // again: in replays, in recordings for them and in network games
+    std::unique_ptr<FileWatcher> level_watcher;
+    if (!input.is_replaying() && options.record_input.empty() && !session) {
+        try {
+            level_watcher = std::make_unique<FileWatcher>(LEVELS_PATH);
+        } catch (const std::exception &error) {
+            TraceLog(LOG_WARNING, "LEVELS: %s, no reloading on edits", error.what());
+        }
+    }
+
+    FrameCapture capture;
+    if (!options.capture_directory.empty()) {
+        try {
+            capture.start(options.capture_directory, options.capture_interval);
+        } catch (const std::exception &error) {
+            TraceLog(LOG_WARNING, "CAPTURE: %s", error.what());
+        }
+    }
+
+    // Replays ignore the keyboard, so there is no latency to hide or measure
+    InputLatch latch;
+    latch.set_late(options.late_latch && !input.is_replaying(), 1.0 / TARGET_FPS);
+    InputLatency &latency = InputLatency::getInstance();
+    latency.set_enabled(options.latency && !input.is_replaying());
+
+    // Frame telemetry is written on exit, including on SIGINT and SIGTERM, and on SIGUSR1 while playing
+    FrameTelemetry &telemetry = FrameTelemetry::getInstance();
+    telemetry.set_frame_budget(1.0 / TARGET_FPS);
+    std::signal(SIGINT, request_exit);
+    std::signal(SIGTERM, request_exit);
+#ifdef SIGUSR1
+    std::signal(SIGUSR1, request_telemetry_write);
+#endif
+
+    // Only the main thread's allocations count against its frames; the workers have their own pace
+    size_t allocations_before_frame = thread_heap_allocation_count;
+    while (!WindowShouldClose() && !exit_requested && !input.is_finished()) {
+        TRACE_ZONE("frame");
+        telemetry.begin_frame();
+
+        // The counters of the frame that just ended are what the HUD shows
+        size_t allocations = thread_heap_allocation_count;
+        last_frame_counters = current_frame_counters;
+        last_frame_counters.allocations = allocations - allocations_before_frame;
+        current_frame_counters = {};
+        allocations_before_frame = allocations;
 
-        UpdateMusicStream(music);
+#ifdef PLATFORMER_ZERO_ALLOCATION_CHECK
+        check_frame_allocations(last_frame_counters.allocations);
+#endif
 
-        update_game();
+        if (level_watcher && level_watcher->poll()) {
+            size_t allocations_before_reload = thread_heap_allocation_count;
+            reload_levels();
+            // Reloading is not part of the frame
+            allocations_before_frame += thread_heap_allocation_count - allocations_before_reload;
+        }
+
+        BeginDrawing();
+
+        const latched_input latched = latch.latch();
+        current_input = input.next(latched.input);
+        telemetry.mark(INPUT_PHASE);
+        if (session) {
+            session->advance(current_input);
+        } else {
+            update_game();
+        }
+        telemetry.mark(UPDATE_PHASE);
+        capture.begin_frame();
         draw_game();
+        capture.end_frame();
+        telemetry.mark(DRAW_PHASE);
+
+        if (current_input.is_pressed(HUD_ACTION)) {
+            performance_hud_visible = !performance_hud_visible;
+        }
+
+#ifdef PLATFORMER_TRACE
+        // Saves the recent frames of every thread, to see which phase a hitch came from
+        if (current_input.is_pressed(TRACE_ACTION)) {
+            size_t allocations_before_dump = thread_heap_allocation_count;
+            if (TraceRecorder::getInstance().write_chrome_trace("trace.json", TRACE_DUMP_SECONDS)) {
+                TraceLog(LOG_INFO, "TRACE: Wrote the last %.0f seconds to trace.json", TRACE_DUMP_SECONDS);
+            } else {
+                TraceLog(LOG_WARNING, "TRACE: Could not write trace.json");
+            }
+            // Writing the trace is not part of the frame
+            allocations_before_frame += thread_heap_allocation_count - allocations_before_dump;
+        }
+#endif
+
+        if (telemetry_write_requested) {
+            telemetry_write_requested = 0;
+            write_telemetry();
+        }
 
         EndDrawing();
+        const int64_t present_us = latency.now_us();
+
+        telemetry.mark(PRESENT_PHASE);
+        const frame_record &frame = telemetry.end_frame(static_cast<uint8_t>(game_state), static_cast<int16_t>(level_index));
+        latch.presented(present_us, frame.phase_end_us[DRAW_PHASE] - frame.phase_end_us[INPUT_PHASE]);
+        if (latched.edge_us >= 0) {
+            latency.record(frame.frame, latched.edge_us, present_us);
+        }
+        frame_timings[frame_timing_count++ % FRAME_TIMING_HISTORY] = {
+            static_cast<float>(frame.phase_end_us[PRESENT_PHASE]) / 1000.0f,
+            static_cast<float>(frame.phase_end_us[UPDATE_PHASE] - frame.phase_end_us[INPUT_PHASE]) / 1000.0f,
+            static_cast<float>(frame.phase_end_us[DRAW_PHASE] - frame.phase_end_us[UPDATE_PHASE]) / 1000.0f
+        };
+    }
+    write_telemetry();
+    if (latency.is_enabled()) {
+        write_latency(latency, latch.is_late() ? "late_latch" : "default");
+    }
+    capture.stop();
+    if (session) {
+        TraceLog(LOG_INFO, "NETPLAY: %llu frames, %llu rollbacks replaying %llu frames, %llu stalls",
+                 static_cast<unsigned long long>(session->get_frame()),
+                 static_cast<unsigned long long>(session->get_rollback_count()),
+                 static_cast<unsigned long long>(session->get_resimulated_frames()),
+                 static_cast<unsigned long long>(session->get_stall_count()));
     }
 
     LevelController::getInstanceLevel().unload_level();
@@ -150,8 +360,6 @@ int main() {
     unload_images();
     unload_fonts();
 
-    UnloadMusicStream(music);
-
     CloseAudioDevice();
     CloseWindow();
 
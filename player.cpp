@@ -3,163 +3,258 @@
 #include  "enemies_controller.h"
 #include "level.h"
 #include "level_controller.h"
+#include "audio_thread.h"
+#include "animation.h"
+#include "trace.h"
+#include <algorithm>
 
 void Player::reset_player_stats() {
     player_lives = MAX_PLAYER_LIVES;
 
-    for (int i = 0; i < LEVEL_COUNT; i++) {
-        player_level_scores[i] = 0;
-    }
+    std::fill(player_level_scores.begin(), player_level_scores.end(), 0);
 }
 
 void Player::increment_player_score() {
-    PlaySound(coin_sound);
+    AudioThread::getInstance().play(COIN_SOUND);
     player_level_scores[level_index]++;
 }
 
 int Player::get_total_player_score() {
     int sum = 0;
 
-    for (int i = 0; i < LEVEL_COUNT; i++) {
-        sum += player_level_scores[i];
+    for (int score : player_level_scores) {
+        sum += score;
     }
 
     return sum;
 }
 
 void Player::spawn_player() {
-    player_y_velocity = 0;
+    players.resize(player_count);
 
-    for (size_t row = 0; row < LevelController::getInstanceLevel().get_current_level().get_rows(); ++row) {
-        for (size_t column = 0; column < LevelController::getInstanceLevel().get_current_level().get_columns(); ++column) {
-            char cell = Level::get_level_cell(row, column);;
+    // Spawn markers are found through the bitplanes, skipping everything else
+    Level &level = LevelController::getInstanceLevel().get_current_level();
+    Vector2 spawn = players.get<Position>(0).value;
+    bool spawned = false;
+    level.get_bitplanes().for_each<SPAWN_TRAIT>(0, level.get_rows() - 1, 0, level.get_columns() - 1, [&](size_t row, size_t column, uint8_t kind) {
+        if (kind != PLAYER_TILE || spawned) return;
+        spawn = {static_cast<float>(column), static_cast<float>(row)};
+        LevelController::getInstanceLevel().set_level_cell(row, column, AIR);
+        spawned = true;
+    });
 
-            if (cell == PLAYER) {
-                Player::getInstancePlayer().set_player_posX(column);
-                Player::getInstancePlayer().set_player_posY(row);
-                LevelController::getInstanceLevel().set_level_cell(getInstancePlayer().get_player_posX(), getInstancePlayer().get_player_posY(), AIR);
-                return;
-            }
-        }
-    }
+    // Let the players jump right away if they start on the ground
+    const bool on_ground = LevelController::getInstanceLevel().is_colliding_with<SOLID_TRAIT>({spawn.x, spawn.y + GROUND_SNAP_DISTANCE});
+    uint32_t player = 0;
+    players.for_each<Position, Velocity, GroundContact, Animation>([&](Position &position, Velocity &velocity, GroundContact &ground, Animation &animation) {
+        position.value = spawn;
+        velocity.value = {0.0f, 0.0f};
+        ground = {on_ground, -1};
+        animation = {PLAYER_WALK_FORWARD_CLIP, animation_phase(player++), 0};
+    });
 }
 
 void Player::kill_player() {
     // Decrement a life and reset all collected coins in the current level
-    PlaySound(player_death_sound);
+    AudioThread::getInstance().play(PLAYER_DEATH_SOUND);
     game_state = DEATH_STATE;
     player_lives--;
     player_level_scores[level_index] = 0;
 }
 
-void Player::move_player_horizontally(float delta) {
-    // See if the player can move further without touching a wall;
-    // otherwise, prevent them from getting into a wall by rounding their position
-    float next_x = Player::getInstancePlayer().get_player_posX() + delta;
-    if (!LevelController::getInstanceLevel().is_colliding({next_x, Player::getInstancePlayer().get_player_posY()}, WALL)) {
-        Player::getInstancePlayer().set_player_posX(next_x);
-    } else {
-        player_pos.x = roundf(player_pos.x);
-        return;
-    }
+// Sweeps a step against the walls; on a hit, stops flush against the wall
+static void move_horizontally(Vector2 &player_pos, Facing &facing, Animation &animation, const float delta) {
+    SweepResult sweep = LevelController::getInstanceLevel().sweep<SOLID_TRAIT>(player_pos, {delta, 0.0f});
+    player_pos.x = sweep.position.x;
+    if (sweep.hit) return;
 
     // For drawing player animations
-    looks_forward = delta > 0;
-    if (delta != 0) moves = true;
+    facing.forward = delta > 0;
+    if (delta != 0) {
+        facing.moving = true;
+        play_animation(animation, facing.forward ? PLAYER_WALK_FORWARD_CLIP : PLAYER_WALK_BACKWARDS_CLIP);
+    }
+}
+
+void Player::steer_players(const frame_input *inputs) {
+    const frame_input *input = inputs;
+    players.for_each<Position, Velocity, GroundContact, Facing, Animation>([&](Position &position, Velocity &velocity, const GroundContact &ground, Facing &facing, Animation &animation) {
+        // Drawing shows the walking animation only for frames the player moved in
+        facing.moving = false;
+
+        if (input->is_held(MOVE_RIGHT_ACTION)) {
+            move_horizontally(position.value, facing, animation, PLAYER_MOVEMENT_SPEED);
+        }
+
+        if (input->is_held(MOVE_LEFT_ACTION)) {
+            move_horizontally(position.value, facing, animation, -PLAYER_MOVEMENT_SPEED);
+        }
+
+        // The last gravity sweep decides whether the player is allowed to jump
+        if (input->is_held(JUMP_ACTION) && ground.on_ground) {
+            velocity.value.y = -JUMP_STRENGTH;
+        }
+        ++input;
+    });
 }
 
 void Player::update_player_gravity() {
-    // Bounce downwards if approaching a ceiling with upwards velocity
-    if (LevelController::getInstanceLevel().is_colliding({Player::getInstancePlayer().get_player_posX(), Player::getInstancePlayer().get_player_posY() - 0.1f}, WALL) && player_y_velocity < 0) {
-        player_y_velocity = CEILING_BOUNCE_OFF;
-    }
+    LevelController &level_controller = LevelController::getInstanceLevel();
+    players.for_each<Position, Velocity, GroundContact>([&](Position &position, Velocity &velocity, GroundContact &ground) {
+        Vector2 &player_pos = position.value;
+        float &player_y_velocity = velocity.value.y;
 
-    // Add gravity to player's y-position
+        // Sweep the vertical move; when falling, reach a little further so the player settles onto
+        // ground that is just below them instead of hovering above it
+        float reach = player_y_velocity >= 0 ? player_y_velocity + GROUND_SNAP_DISTANCE : player_y_velocity;
+        SweepResult sweep = level_controller.sweep<SOLID_TRAIT>(player_pos, {0.0f, reach});
 
-    player_pos.y += player_y_velocity;
-    player_y_velocity += GRAVITY_FORCE;
+        ground.on_ground = sweep.hit && sweep.normal.y < 0;
+        ground.collider = ground.on_ground ? sweep.collider : -1;
+        if (ground.on_ground) {
+            // Landed: stand on the ground and zero player's y-velocity
+            player_pos.y = sweep.position.y;
+            player_y_velocity = 0;
 
-    // If the player is on ground, zero player's y-velocity
-    // If the player is *in* ground, pull them out by rounding their position
-    player_on_ground = LevelController::getInstanceLevel().is_colliding({Player::getInstancePlayer().get_player_posX(), Player::getInstancePlayer().get_player_posY() + 0.1f}, WALL);
-    if (player_on_ground) { // Use the getter to check the state
-        player_y_velocity = 0;
-        player_pos.y = roundf(player_pos.y);
-    }
+            // Stepping on a falling block sets it off
+            if (ground.collider >= 0) {
+                level_controller.get_dynamic_colliders().stand_on(ground.collider);
+            }
+        } else if (sweep.hit) {
+            // Bounce downwards off a ceiling
+            player_pos.y = sweep.position.y;
+            player_y_velocity = CEILING_BOUNCE_OFF;
+        } else {
+            // Add gravity to player's y-position
+            player_pos.y += player_y_velocity;
+            player_y_velocity += GRAVITY_FORCE;
+        }
+    });
 }
 
-void Player::update_player() {
-    getInstancePlayer().update_player_gravity();
+void Player::update_players() {
+    TRACE_ZONE("update_players");
+    ride_colliders();
+    update_player_gravity();
+    touch_level();
+}
 
-    // Interacting with other level elements
-    if (LevelController::getInstanceLevel().is_colliding(player_pos, COIN)) {
-        LevelController::getInstanceLevel().get_collider(player_pos, COIN) = AIR; // Removes the coin
-        Player::getInstancePlayer().increment_player_score();
-    }
+void Player::ride_colliders() {
+    LevelController &level_controller = LevelController::getInstanceLevel();
+    players.for_each<Position, GroundContact>([&](Position &position, const GroundContact &ground) {
+        // Ride along with the moving collider underfoot, stopping at walls
+        if (ground.on_ground && ground.collider >= 0) {
+            Vector2 carry = level_controller.get_dynamic_colliders().get(ground.collider).displacement;
+            position.value = level_controller.sweep<SOLID_TRAIT>(position.value, carry).position;
+        }
+    });
+}
+
+void Player::touch_level() {
+    LevelController &level_controller = LevelController::getInstanceLevel();
+    EnemiesController &enemies_controller = EnemiesController::getInstance();
+    bool at_exit = false;
+    bool left_level = false;
 
-    if (LevelController::getInstanceLevel().is_colliding(player_pos, EXIT)) {
-        // Reward player for being swift
-        if (timer > 0) {
-            // For every 9 seconds remaining, award the player 1 coin
-            timer -= 25;
-            time_to_coin_counter += 5;
+    players.for_each<Position, Velocity>([&](const Position &position, Velocity &velocity) {
+        // A death or a new level ends the frame for the players after
+        if (game_state != GAME_STATE || left_level) return;
+        const Vector2 player_pos = position.value;
 
-            if (time_to_coin_counter / 60 > 1) {
+        // Interacting with other level elements, all found by a single query
+        TileContacts contacts = level_controller.query_tiles(player_pos);
+
+        for (uint8_t i = 0; i < contacts.count; ++i) {
+            if (TILE_KIND_TRAITS[contacts.cell_kinds[i]] & COLLECTIBLE_TRAIT) {
+                level_controller.set_level_cell(contacts.cells[i].row, contacts.cells[i].column, AIR); // Removes the coin
                 increment_player_score();
-                time_to_coin_counter = 0;
             }
-        } else {
-            // Allow the player to exit after the level timer goes to zero
-            LevelController::getInstanceLevel().load_level(1);
-            PlaySound(exit_sound);
         }
-    } else {
-        // Decrement the level timer if not at an exit
-        if (timer >= 0) timer--;
-    }
 
-    // Kill the player if they touch a spike or fall below the level
-    if (LevelController::getInstanceLevel().is_colliding(player_pos, SPIKE) || Player::getInstancePlayer().get_player_posY() > LevelController::getInstanceLevel().get_current_level().get_rows()) {
-        Player::getInstancePlayer().kill_player();
-    }
+        if (contacts.touches_any<GOAL_TRAIT>()) {
+            at_exit = true;
 
-    // Upon colliding with an enemy...
-    if (EnemiesController::getInstance().is_colliding_with_enemies(Player::getInstancePlayer().get_player_pos())) {
-        // ...check if their velocity is downwards...
-        if (player_y_velocity > 0) {
-            // ...if yes, award the player and kill the enemy
-            EnemiesController::getInstance().remove_colliding_enemy(Player::getInstancePlayer().get_player_pos());
-            PlaySound(kill_enemy_sound);
+            // Reward player for being swift
+            if (timer > 0) {
+                // For every 9 seconds remaining, award the player 1 coin
+                timer -= 25;
+                time_to_coin_counter += 5;
 
-            increment_player_score();
-            player_y_velocity = -BOUNCE_OFF_ENEMY;
-        } else {
-            // ...if not, kill the player
-            Player::getInstancePlayer().kill_player();
+                if (time_to_coin_counter / 60 > 1) {
+                    increment_player_score();
+                    time_to_coin_counter = 0;
+                }
+            } else {
+                // Allow the player to exit after the level timer goes to zero
+                level_controller.load_level(1);
+                AudioThread::getInstance().play(EXIT_SOUND);
+
+                // The contacts belong to the previous level
+                left_level = true;
+                return;
+            }
         }
-    }
+
+        // Kill the player if they touch a spike or fall below the level
+        if (contacts.touches_any<LETHAL_TRAIT>() || player_pos.y > level_controller.get_current_level().get_rows()) {
+            kill_player();
+        }
+
+        // Upon colliding with an enemy...
+        if (enemies_controller.is_colliding_with_enemies(player_pos)) {
+            // ...check if their velocity is downwards...
+            if (velocity.value.y > 0) {
+                // ...if yes, award the player and kill the enemy
+                enemies_controller.remove_colliding_enemy(player_pos);
+                AudioThread::getInstance().play(KILL_ENEMY_SOUND);
+
+                increment_player_score();
+                velocity.value.y = -BOUNCE_OFF_ENEMY;
+            } else {
+                // ...if not, kill the player
+                kill_player();
+            }
+        }
+    });
+
+    // Decrement the level timer while nobody is at the exit
+    if (!at_exit && !left_level && timer >= 0) timer--;
 }
 
-void Player::draw_player() {
-    horizontal_shift = (screen_size.x - cell_size) / 2;
+void Player::update_animations() {
+    step_animations(players.data<Animation>(), players.size());
+}
 
+static void draw_player(const Vector2 player_pos, const bool on_ground, const Facing facing, const Animation &animation, const float camera_x) {
     // Shift the camera to the center of the screen to allow to see what is in front of the player
     Vector2 pos = {
-        horizontal_shift,
-        Player::getInstancePlayer().get_player_posY() * cell_size
+        (player_pos.x - camera_x) * cell_size + horizontal_shift,
+        player_pos.y * cell_size
 };
 
     // Pick an appropriate sprite for the player
     if (game_state == GAME_STATE) {
-        if (!(Player::getInstancePlayer().is_player_on_ground())) {
-            draw_image((Player::getInstancePlayer().is_looking_forward() ? player_jump_forward_image : player_jump_backwards_image), pos, cell_size);
-        } else if (Player::getInstancePlayer().is_moving()) {
-            draw_sprite((Player::getInstancePlayer().is_looking_forward() ? player_walk_forward_sprite : player_walk_backwards_sprite), pos, cell_size);
-            Player::getInstancePlayer().set_is_moving(false);
+        if (!on_ground) {
+            draw_image((facing.forward ? player_jump_forward_image : player_jump_backwards_image), pos, cell_size);
+        } else if (facing.moving) {
+            draw_animation(animation, pos, cell_size);
         } else {
-            draw_image((Player::getInstancePlayer().is_looking_forward() ? player_stand_forward_image : player_stand_backwards_image), pos, cell_size);
+            draw_image((facing.forward ? player_stand_forward_image : player_stand_backwards_image), pos, cell_size);
         }
     } else {
         draw_image(player_dead_image, pos, cell_size);
     }
-}
\ No newline at end of file
+}
+
+void Player::draw_players() const {
+    horizontal_shift = (screen_size.x - cell_size) / 2;
+    const float camera_x = get_player_posX(local_player);
+
+    // The local player goes on top of the others
+    size_t player = 0;
+    players.for_each<Position, GroundContact, Facing, Animation>([&](const Position &position, const GroundContact &ground, const Facing &facing, const Animation &animation) {
+        if (player++ != local_player) draw_player(position.value, ground.on_ground, facing, animation, camera_x);
+    });
+    draw_player(get_player_pos(local_player), players.get<GroundContact>(local_player).on_ground,
+                players.get<Facing>(local_player), players.get<Animation>(local_player), camera_x);
+}
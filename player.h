@@ -4,6 +4,11 @@
 #include "globals.h"
 #include "level.h"
 #include "level_controller.h"
+#include "archetype.h"
+#include "components.h"
+
+// Position, vertical speed, the ground underfoot, which way the player faces and the walk cycle
+using PlayerArchetype = Archetype<Position, Velocity, GroundContact, Facing, Animation>;
 
 class Player {
 public:
@@ -17,67 +22,69 @@ public:
     Player(Player&&) = delete;
     Player operator=(Player&&) = delete;
 
-    [[nodiscard]] Vector2 get_player_pos() {
-        return player_pos;
-    }
-
-    [[nodiscard]] float get_player_posX() {
-        return player_pos.x;
+    [[nodiscard]] const PlayerArchetype& get_players() const {
+        return players;
     }
 
-    [[nodiscard]] float get_player_posY() {
-        return player_pos.y;
+    void set_players(const PlayerArchetype &state) {
+        players = state;
     }
 
-    void set_player_posX(const float x) {
-        this->player_pos.x = x;
+    // The first player unless asked otherwise: the enemies and the endless level follow them,
+    // the camera follows local_player
+    [[nodiscard]] Vector2 get_player_pos(const size_t player = 0) const {
+        return players.get<Position>(player).value;
     }
 
-    void set_player_posY(const float y) {
-        this->player_pos.y = y;
+    [[nodiscard]] float get_player_posX(const size_t player = 0) const {
+        return get_player_pos(player).x;
     }
 
-    [[nodiscard]] bool is_player_on_ground() const {
-        return player_on_ground;
+    [[nodiscard]] float get_player_posY(const size_t player = 0) const {
+        return get_player_pos(player).y;
     }
 
-    void set_is_player_on_ground(const bool is_player_on_ground) {
-        this->player_on_ground = is_player_on_ground;
+    void set_player_posX(const float x, const size_t player = 0) {
+        players.get<Position>(player).value.x = x;
     }
 
-    [[nodiscard]] bool is_looking_forward() const {
-        return looks_forward;
+    [[nodiscard]] int32_t get_ground_collider(const size_t player = 0) const {
+        return players.get<GroundContact>(player).collider;
     }
 
-    void set_is_looking_forward(const bool is_looking_forward) {
-        this->looks_forward = is_looking_forward;
-    }
-
-    [[nodiscard]] bool is_moving() const {
-        return moves;
-    }
-
-    void set_is_moving(const bool is_moving) {
-        this->moves = is_moving;
+    void set_ground_collider(const int32_t index, const size_t player = 0) {
+        players.get<GroundContact>(player).collider = index;
     }
 
     void reset_player_stats();
     void increment_player_score();
     int get_total_player_score();
+    // Puts every player at the level's spawn marker
     void spawn_player();
     void kill_player();
-    void move_player_horizontally(float delta);
-    void draw_player();
+
+    // The systems below each run over every player. The players move on their own inputs, one
+    // per player in order, then ride, fall and touch the level and the enemies in that order.
+    void steer_players(const frame_input *inputs);
+    void update_players();
     void update_player_gravity();
-    void update_player();
+    // Steps the walk cycles of all players
+    void update_animations();
+    // Draws every player, local_player in the middle of the screen and on top of the others
+    void draw_players() const;
 
 private:
-    Player() = default;
+    Player() {
+        players.push_back({}, {}, {false, -1}, {}, {PLAYER_WALK_FORWARD_CLIP, 0, 0});
+    }
     ~Player() = default;
-    Vector2 player_pos;
-    bool player_on_ground;
-    bool looks_forward;
-    bool moves;
+
+    // Moving colliders carry whoever stands on them
+    void ride_colliders();
+    // Coins, the exit, spikes and enemies
+    void touch_level();
+
+    PlayerArchetype players;
 };
 
 #endif //PLAYER_H
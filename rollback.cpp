@@ -0,0 +1,258 @@
+#include "rollback.h"
+#include "audio_thread.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+/* UDP Transport */
+
+#ifndef _WIN32
+
+static_assert(sizeof(sockaddr_in) <= 16, "The peer address does not fit");
+
+static int open_udp_socket(const uint16_t port) {
+    const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) throw std::runtime_error("Could not open a UDP socket");
+
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(port);
+    if (::bind(fd, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) < 0 ||
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK) < 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not bind UDP port " + std::to_string(port));
+    }
+    return fd;
+}
+
+UdpTransport::UdpTransport(const uint16_t port)
+    : socket_fd(open_udp_socket(port)) {}
+
+UdpTransport::UdpTransport(const std::string &host, const uint16_t port) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo *found = nullptr;
+    if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &found) != 0 || found == nullptr) {
+        throw std::runtime_error("Could not resolve " + host);
+    }
+    std::memcpy(peer_address.data(), found->ai_addr, sizeof(sockaddr_in));
+    ::freeaddrinfo(found);
+
+    // Any free local port will do, the host answers wherever the packets came from
+    socket_fd = open_udp_socket(0);
+    has_peer = true;
+}
+
+UdpTransport::~UdpTransport() {
+    if (socket_fd >= 0) ::close(socket_fd);
+}
+
+void UdpTransport::send(const uint8_t *data, const size_t size) {
+    if (!has_peer) return;
+    // A full send buffer is just another lost packet
+    ::sendto(socket_fd, data, size, 0, reinterpret_cast<const sockaddr*>(peer_address.data()), sizeof(sockaddr_in));
+}
+
+size_t UdpTransport::receive(uint8_t *data, const size_t capacity) {
+    sockaddr_in sender{};
+    socklen_t sender_size = sizeof(sender);
+    const ssize_t size = ::recvfrom(socket_fd, data, capacity, 0, reinterpret_cast<sockaddr*>(&sender), &sender_size);
+    if (size <= 0) return 0;
+
+    if (!has_peer) {
+        std::memcpy(peer_address.data(), &sender, sizeof(sender));
+        has_peer = true;
+    }
+    return static_cast<size_t>(size);
+}
+
+#else
+
+UdpTransport::UdpTransport(uint16_t) {
+    throw std::runtime_error("Network play is not supported on Windows yet");
+}
+
+UdpTransport::UdpTransport(const std::string&, uint16_t) {
+    throw std::runtime_error("Network play is not supported on Windows yet");
+}
+
+UdpTransport::~UdpTransport() = default;
+
+void UdpTransport::send(const uint8_t*, size_t) {}
+
+size_t UdpTransport::receive(uint8_t*, size_t) {
+    return 0;
+}
+
+#endif
+
+/* Rollback Session */
+
+static void write_u32(uint8_t *out, const uint64_t value) {
+    for (int byte = 0; byte < 4; ++byte) out[byte] = static_cast<uint8_t>(value >> (8 * byte));
+}
+
+static uint32_t read_u32(const uint8_t *in) {
+    uint32_t value = 0;
+    for (int byte = 0; byte < 4; ++byte) value |= static_cast<uint32_t>(in[byte]) << (8 * byte);
+    return value;
+}
+
+RollbackSession::RollbackSession(InputTransport &transport, const size_t local_player)
+    : transport(transport), local_player(local_player) {}
+
+bool RollbackSession::advance(const frame_input &local) {
+    TRACE_ZONE("rollback_advance");
+    receive();
+
+    // Take back the frames that ran on a wrong guess and play them again with what was really pressed
+    if (first_misprediction < frame) {
+        TRACE_ZONE("resimulate");
+        restore_game(snapshots[first_misprediction % SNAPSHOTS]);
+
+        // Their sounds were played the first time around
+        AudioThread::getInstance().set_muted(true);
+        for (uint64_t replayed = first_misprediction; replayed < frame; ++replayed) {
+            simulate(replayed);
+        }
+        AudioThread::getInstance().set_muted(false);
+
+        ++rollbacks;
+        resimulated_frames += frame - first_misprediction;
+    }
+    first_misprediction = UINT64_MAX;
+
+    // Too far ahead to roll back, or more unacknowledged inputs than a packet holds
+    if (frame >= remote_received + MAX_ROLLBACK_FRAMES || frame >= local_acknowledged + HISTORY) {
+        carried_presses |= local.pressed;
+        ++stalls;
+        send();
+        update_checksums();
+        return false;
+    }
+
+    frame_input input = local;
+    input.pressed |= carried_presses;
+    carried_presses = 0;
+    local_inputs[frame % HISTORY] = input;
+
+    simulate(frame);
+    ++frame;
+    send();
+    update_checksums();
+    return true;
+}
+
+void RollbackSession::simulate(const uint64_t simulated_frame) {
+    save_game(snapshots[simulated_frame % SNAPSHOTS]);
+
+    const frame_input remote = simulated_frame < remote_received ? remote_inputs[simulated_frame % HISTORY] : predict_remote();
+    predicted_inputs[simulated_frame % HISTORY] = remote;
+
+    frame_input inputs[MAX_PLAYERS] = {};
+    inputs[local_player] = local_inputs[simulated_frame % HISTORY];
+    inputs[local_player == 0 ? 1 : 0] = remote;
+    step_game(inputs);
+}
+
+frame_input RollbackSession::predict_remote() const {
+    if (remote_received == 0) return {};
+
+    // Buttons tend to stay held, but a press is a single frame
+    const frame_input &last = remote_inputs[(remote_received - 1) % HISTORY];
+    return {last.held, 0};
+}
+
+void RollbackSession::receive() {
+    uint8_t packet[InputTransport::MAX_PACKET_SIZE];
+    while (const size_t size = transport.receive(packet, sizeof(packet))) {
+        if (size < PACKET_HEADER_SIZE || size != PACKET_HEADER_SIZE + 2 * size_t{packet[8]}) continue;
+
+        // Frame numbers go out as 32 bits, over two years of play at 60 fps
+        const uint64_t acknowledged = read_u32(packet);
+        const uint64_t first = read_u32(packet + 4);
+        local_acknowledged = std::max(local_acknowledged, std::min(acknowledged, frame));
+
+        for (size_t i = 0; i < packet[8]; ++i) {
+            const uint64_t received_frame = first + i;
+            // Inputs already known, or past a gap left by a lost or late packet
+            if (received_frame < remote_received) continue;
+            if (received_frame > remote_received || remote_received >= frame + HISTORY - SNAPSHOTS) break;
+
+            const frame_input input = {packet[PACKET_HEADER_SIZE + 2 * i], packet[PACKET_HEADER_SIZE + 2 * i + 1]};
+            const frame_input &predicted = predicted_inputs[received_frame % HISTORY];
+            if (received_frame < frame && (input.held != predicted.held || input.pressed != predicted.pressed)) {
+                first_misprediction = std::min(first_misprediction, received_frame);
+            }
+            remote_inputs[received_frame % HISTORY] = input;
+            ++remote_received;
+        }
+    }
+}
+
+void RollbackSession::send() {
+    uint8_t packet[InputTransport::MAX_PACKET_SIZE];
+    const uint64_t count = frame - local_acknowledged;
+    write_u32(packet, remote_received);
+    write_u32(packet + 4, local_acknowledged);
+    packet[8] = static_cast<uint8_t>(count);
+
+    for (uint64_t i = 0; i < count; ++i) {
+        const frame_input &input = local_inputs[(local_acknowledged + i) % HISTORY];
+        packet[PACKET_HEADER_SIZE + 2 * i] = input.held;
+        packet[PACKET_HEADER_SIZE + 2 * i + 1] = input.pressed;
+    }
+    transport.send(packet, PACKET_HEADER_SIZE + 2 * count);
+}
+
+void RollbackSession::update_checksums() {
+    // The game before a frame is final once every input before it is known on both sides; the
+    // stall keeps such frames within the snapshots still held
+    while (checksum_count < frame && checksum_count <= remote_received) {
+        checksums[checksum_count % HISTORY] = checksum_game(snapshots[checksum_count % SNAPSHOTS]);
+        ++checksum_count;
+    }
+}
+
+uint64_t RollbackSession::get_frame() const {
+    return frame;
+}
+
+uint64_t RollbackSession::get_confirmed_frame() const {
+    return std::min(remote_received, frame);
+}
+
+uint64_t RollbackSession::get_checksum(const uint64_t checked_frame) const {
+    if (checked_frame >= checksum_count || checked_frame + HISTORY < checksum_count) {
+        throw std::out_of_range("No checksum kept for frame " + std::to_string(checked_frame));
+    }
+    return checksums[checked_frame % HISTORY];
+}
+
+uint64_t RollbackSession::get_checksum_count() const {
+    return checksum_count;
+}
+
+uint64_t RollbackSession::get_rollback_count() const {
+    return rollbacks;
+}
+
+uint64_t RollbackSession::get_resimulated_frames() const {
+    return resimulated_frames;
+}
+
+uint64_t RollbackSession::get_stall_count() const {
+    return stalls;
+}
@@ -0,0 +1,188 @@
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+
+#include "game.h"
+#include "input.h"
+#include "split_mix.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+/* Transports */
+
+// Carries the packets of a rollback session to the other machine. Packets may be lost,
+// duplicated or reordered; neither call waits.
+class InputTransport {
+public:
+    static constexpr size_t MAX_PACKET_SIZE = 128;
+
+    virtual ~InputTransport() = default;
+
+    virtual void send(const uint8_t *data, size_t size) = 0;
+    // Copies the next packet that arrived into data and returns its size, or 0 if none is waiting
+    virtual size_t receive(uint8_t *data, size_t capacity) = 0;
+};
+
+// Both ends in one process, for tests: a packet arrives latency ticks after it was sent, plus up
+// to jitter more, unless it is lost. Each end's clock is ticked by whoever drives it, once a frame.
+class LoopbackTransport : public InputTransport {
+public:
+    // Connects two ends, both ways
+    static void connect(LoopbackTransport &a, LoopbackTransport &b);
+
+    void set_conditions(uint32_t latency_ticks, uint32_t jitter_ticks, double loss, uint64_t seed);
+    void tick();
+
+    void send(const uint8_t *data, size_t size) override;
+    size_t receive(uint8_t *data, size_t capacity) override;
+
+private:
+    struct packet {
+        uint64_t arrival;
+        size_t size;
+        std::array<uint8_t, MAX_PACKET_SIZE> data;
+    };
+
+    LoopbackTransport *peer = nullptr;
+    std::deque<packet> inbox;
+    uint64_t clock = 0;
+    uint32_t latency = 0;
+    uint32_t jitter = 0;
+    double loss = 0.0;
+    SplitMix64 random;
+};
+
+// A UDP socket talking to one peer. The host learns the peer's address from its first packet.
+// Throws std::runtime_error when the socket cannot be set up; only POSIX systems are supported.
+class UdpTransport : public InputTransport {
+public:
+    // Hosts on the given port
+    explicit UdpTransport(uint16_t port);
+    // Joins a host
+    UdpTransport(const std::string &host, uint16_t port);
+    ~UdpTransport() override;
+
+    UdpTransport(const UdpTransport&) = delete;
+    UdpTransport& operator=(const UdpTransport&) = delete;
+
+    void send(const uint8_t *data, size_t size) override;
+    size_t receive(uint8_t *data, size_t capacity) override;
+
+private:
+    int socket_fd = -1;
+    bool has_peer = false;
+    std::array<uint8_t, 16> peer_address{}; // A sockaddr_in, kept opaque to leave the socket headers out
+};
+
+/* Rollback Session */
+
+// Runs the game in lockstep with another machine while only exchanging inputs. Every frame runs
+// at once with the remote input predicted to repeat the last one received; when the real input
+// turns out different, the game goes back to the snapshot before that frame and plays the frames
+// since again. Getting more than MAX_ROLLBACK_FRAMES ahead of the remote input stalls instead.
+//
+// Packets carry every local input the remote side has not acknowledged yet, so a lost packet is
+// made up for by the next one:
+//   u32 acknowledged (remote inputs received so far), u32 first frame, u8 count, count x (held, pressed)
+class RollbackSession {
+public:
+    static constexpr uint64_t MAX_ROLLBACK_FRAMES = 8;
+    static constexpr uint64_t HISTORY = 32; // Inputs and checksums kept, and unacknowledged inputs allowed
+
+    RollbackSession(InputTransport &transport, size_t local_player);
+
+    // Exchanges inputs and advances the game by a frame. Returns false when it stalled waiting for
+    // the remote side; the presses of a stalled frame carry over to the next.
+    bool advance(const frame_input &local);
+
+    // Frames simulated so far
+    [[nodiscard]] uint64_t get_frame() const;
+    // Frames whose inputs are known on both sides, so their outcome is final
+    [[nodiscard]] uint64_t get_confirmed_frame() const;
+    // The checksum of the game before the given frame; kept for the last HISTORY confirmed frames,
+    // std::out_of_range for the others
+    [[nodiscard]] uint64_t get_checksum(uint64_t frame) const;
+    [[nodiscard]] uint64_t get_checksum_count() const;
+
+    [[nodiscard]] uint64_t get_rollback_count() const;
+    [[nodiscard]] uint64_t get_resimulated_frames() const;
+    [[nodiscard]] uint64_t get_stall_count() const;
+
+private:
+    static constexpr size_t SNAPSHOTS = MAX_ROLLBACK_FRAMES + 1;
+    static constexpr size_t PACKET_HEADER_SIZE = 9;
+
+    void receive();
+    void send();
+    // Simulates the given frame with the inputs known or predicted for it
+    void simulate(uint64_t simulated_frame);
+    void update_checksums();
+    [[nodiscard]] frame_input predict_remote() const;
+
+    InputTransport &transport;
+    size_t local_player;
+
+    uint64_t frame = 0;
+    std::array<frame_input, HISTORY> local_inputs{};
+    std::array<frame_input, HISTORY> remote_inputs{};
+    std::array<frame_input, HISTORY> predicted_inputs{}; // The remote input each simulated frame used
+    uint64_t remote_received = 0; // Remote inputs received, without gaps
+    uint64_t local_acknowledged = 0; // Local inputs the remote side has received
+    uint64_t first_misprediction = UINT64_MAX;
+    uint8_t carried_presses = 0;
+
+    std::array<game_snapshot, SNAPSHOTS> snapshots; // The game before each of the latest frames
+    std::array<uint64_t, HISTORY> checksums{};
+    uint64_t checksum_count = 0;
+
+    uint64_t rollbacks = 0;
+    uint64_t resimulated_frames = 0;
+    uint64_t stalls = 0;
+};
+
+// --- Inline Definitions ---
+
+inline void LoopbackTransport::connect(LoopbackTransport &a, LoopbackTransport &b) {
+    a.peer = &b;
+    b.peer = &a;
+}
+
+inline void LoopbackTransport::set_conditions(uint32_t latency_ticks, uint32_t jitter_ticks, double loss_chance, uint64_t seed) {
+    latency = latency_ticks;
+    jitter = jitter_ticks;
+    loss = loss_chance;
+    random = SplitMix64(seed);
+}
+
+inline void LoopbackTransport::tick() {
+    ++clock;
+}
+
+inline void LoopbackTransport::send(const uint8_t *data, size_t size) {
+    if (peer == nullptr || size > MAX_PACKET_SIZE) return;
+    if (random.chance() < loss) return;
+
+    packet sent{};
+    // Both clocks tick together, so the sender's clock tells the receiver when to deliver
+    sent.arrival = clock + latency + (jitter > 0 ? random.next() % (jitter + 1) : 0);
+    sent.size = size;
+    std::copy(data, data + size, sent.data.begin());
+    peer->inbox.push_back(sent);
+}
+
+inline size_t LoopbackTransport::receive(uint8_t *data, size_t capacity) {
+    // Jitter reorders packets, so any of them may be the next to arrive
+    for (auto waiting = inbox.begin(); waiting != inbox.end(); ++waiting) {
+        if (waiting->arrival > clock || waiting->size > capacity) continue;
+        const size_t size = waiting->size;
+        std::copy(waiting->data.begin(), waiting->data.begin() + size, data);
+        inbox.erase(waiting);
+        return size;
+    }
+    return 0;
+}
+
+#endif // ROLLBACK_H
@@ -0,0 +1,131 @@
+#include "sound_bank.h"
+#include <algorithm>
+
+void SoundBank::set_memory_budget(size_t bytes) {
+    memory_budget = bytes;
+}
+
+std::string SoundBank::find_audio_file(const std::string &path) {
+    // Compressed files win, so a .qoa or .ogg dropped next to a .wav replaces it
+    for (const char *extension : {".qoa", ".ogg", ".wav"}) {
+        std::string file = path + extension;
+        if (FileExists(file.c_str())) return file;
+    }
+    TraceLog(LOG_WARNING, "AUDIO: No .qoa, .ogg or .wav file for %s", path.c_str());
+    return "";
+}
+
+void SoundBank::load_music(const std::string &path) {
+    const std::string file = find_audio_file(path);
+    if (file.empty()) return;
+
+    music = LoadMusicStream(file.c_str());
+    if (music.stream.buffer == nullptr) return;
+    ++streamed_count;
+    PlayMusicStream(music);
+}
+
+void SoundBank::load(sound_id id, const std::string &path, size_t voices) {
+    effect &target = effects[id];
+    const std::string file = find_audio_file(path);
+    if (file.empty()) return;
+
+    // Opened as a stream, a file tells its length without being decoded
+    Music stream = LoadMusicStream(file.c_str());
+    if (stream.stream.buffer == nullptr) return;
+    const size_t decoded_bytes = static_cast<size_t>(stream.frameCount) * DECODED_BYTES_PER_FRAME;
+
+    if (resident_bytes + decoded_bytes > memory_budget) {
+        TraceLog(LOG_INFO, "AUDIO: Streaming %s, decoded it would take %zu KB", file.c_str(), decoded_bytes / 1024);
+        stream.looping = false;
+        target.stream = stream;
+        target.streamed = true;
+        ++streamed_count;
+        return;
+    }
+    UnloadMusicStream(stream);
+
+    target.voices[0] = LoadSound(file.c_str());
+    if (target.voices[0].stream.buffer == nullptr) return;
+    resident_bytes += decoded_bytes;
+
+    // The other voices play the same samples, so they cost no memory
+    target.voice_count = std::clamp<size_t>(voices, 1, MAX_VOICES);
+    for (size_t voice = 1; voice < target.voice_count; ++voice) {
+        target.voices[voice] = LoadSoundAlias(target.voices[0]);
+    }
+}
+
+void SoundBank::unload() {
+    for (effect &target : effects) {
+        if (target.streamed) {
+            UnloadMusicStream(target.stream);
+        } else if (target.voice_count > 0) {
+            for (size_t voice = 1; voice < target.voice_count; ++voice) {
+                UnloadSoundAlias(target.voices[voice]);
+            }
+            UnloadSound(target.voices[0]);
+        }
+        target = {};
+    }
+    if (music.stream.buffer != nullptr) UnloadMusicStream(music);
+    music = {};
+
+    resident_bytes = 0;
+    streamed_count = 0;
+}
+
+void SoundBank::play(sound_id id) {
+    effect &target = effects[id];
+    ++play_count;
+
+    if (target.streamed) {
+        // A stream is a single voice, so a repeat starts it over
+        StopMusicStream(target.stream);
+        PlayMusicStream(target.stream);
+        return;
+    }
+    if (target.voice_count == 0) return;
+
+    // A free voice if there is one, otherwise the one that has been playing the longest
+    size_t voice = 0;
+    for (size_t candidate = 0; candidate < target.voice_count; ++candidate) {
+        if (!IsSoundPlaying(target.voices[candidate])) {
+            voice = candidate;
+            break;
+        }
+        if (target.started[candidate] < target.started[voice]) voice = candidate;
+    }
+    target.started[voice] = play_count;
+    PlaySound(target.voices[voice]);
+}
+
+void SoundBank::stop(sound_id id) {
+    effect &target = effects[id];
+    if (target.streamed) {
+        StopMusicStream(target.stream);
+        return;
+    }
+    for (size_t voice = 0; voice < target.voice_count; ++voice) {
+        StopSound(target.voices[voice]);
+    }
+}
+
+void SoundBank::update_streams() {
+    if (music.stream.buffer != nullptr) UpdateMusicStream(music);
+    for (effect &target : effects) {
+        if (target.streamed && IsMusicStreamPlaying(target.stream)) UpdateMusicStream(target.stream);
+    }
+}
+
+size_t SoundBank::get_memory_budget() const {
+    return memory_budget;
+}
+
+size_t SoundBank::get_resident_bytes() const {
+    return resident_bytes;
+}
+
+size_t SoundBank::get_streamed_count() const {
+    return streamed_count;
+}
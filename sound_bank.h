@@ -0,0 +1,68 @@
+#ifndef SOUND_BANK_H
+#define SOUND_BANK_H
+
+#include "raylib.h"
+#include "globals.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Owns the music and every sound effect. An effect is decoded once on load and played from
+// memory unless decoding it would go over the audio memory budget, in which case it is
+// streamed from its file like the music. Decoded effects get a fixed pool of voices sharing
+// their samples, so quick repeats overlap instead of cutting one another off.
+class SoundBank {
+public:
+    static constexpr size_t MAX_VOICES = 8;
+    // Raylib keeps decoded sounds as stereo 32-bit floats
+    static constexpr size_t DECODED_BYTES_PER_FRAME = 2 * sizeof(float);
+
+    [[nodiscard]] static SoundBank &getInstance() {
+        static SoundBank instance;
+        return instance;
+    }
+
+    SoundBank(const SoundBank&) = delete;
+    SoundBank& operator=(const SoundBank&) = delete;
+
+    void set_memory_budget(size_t bytes);
+
+    // Paths come without an extension: the first of .qoa, .ogg and .wav that exists is loaded
+    void load_music(const std::string &path);
+    void load(sound_id id, const std::string &path, size_t voices);
+    void unload();
+
+    // Only called from the audio thread while it runs
+    void play(sound_id id);
+    void stop(sound_id id);
+    void update_streams();
+
+    [[nodiscard]] size_t get_memory_budget() const;
+    [[nodiscard]] size_t get_resident_bytes() const;
+    [[nodiscard]] size_t get_streamed_count() const;
+
+private:
+    SoundBank() = default;
+    ~SoundBank() = default;
+
+    struct effect {
+        std::array<Sound, MAX_VOICES> voices{};
+        std::array<uint64_t, MAX_VOICES> started{}; // When each voice was last played, in plays
+        size_t voice_count = 0;
+        Music stream{};
+        bool streamed = false;
+    };
+
+    [[nodiscard]] static std::string find_audio_file(const std::string &path);
+
+    Music music{};
+    std::array<effect, SOUND_COUNT> effects{};
+    uint64_t play_count = 0;
+
+    size_t memory_budget = AUDIO_MEMORY_BUDGET;
+    size_t resident_bytes = 0;
+    size_t streamed_count = 0;
+};
+
+#endif // SOUND_BANK_H
@@ -0,0 +1,45 @@
+#ifndef SPLIT_MIX_H
+#define SPLIT_MIX_H
+
+#include <cstdint>
+
+// SplitMix64: a tiny, fast generator that gives the same numbers on every platform, for level
+// generation and for the simulated networks and players of the tools
+class SplitMix64 {
+public:
+    explicit SplitMix64(uint64_t seed = 0);
+
+    [[nodiscard]] uint64_t next();
+    // Uniform in [0, 1)
+    [[nodiscard]] double chance();
+    // Uniform in [low, high]
+    [[nodiscard]] int between(int low, int high);
+
+    // Added to the state on every step; also spreads seeds that are close together
+    static constexpr uint64_t GOLDEN_GAMMA = 0x9E3779B97F4A7C15ull;
+
+private:
+    uint64_t state;
+};
+
+// --- Inline Definitions ---
+
+inline SplitMix64::SplitMix64(const uint64_t seed)
+    : state(seed) {}
+
+inline uint64_t SplitMix64::next() {
+    uint64_t value = (state += GOLDEN_GAMMA);
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+inline double SplitMix64::chance() {
+    return static_cast<double>(next() >> 11) * 0x1.0p-53;
+}
+
+inline int SplitMix64::between(const int low, const int high) {
+    return low + static_cast<int>(next() % static_cast<uint64_t>(high - low + 1));
+}
+
+#endif // SPLIT_MIX_H
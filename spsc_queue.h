@@ -0,0 +1,50 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Fixed-size queue between exactly one producer thread and one consumer thread. Neither
+// side ever locks or waits: push fails when the queue is full and pop when it is empty.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer only
+    bool push(const T &value);
+    // Consumer only
+    bool pop(T &value);
+
+private:
+    std::array<T, Capacity> slots{};
+
+    // Counts of values pushed and popped, on separate cache lines so the two threads do not share one
+    alignas(64) std::atomic<size_t> pushed{0};
+    alignas(64) std::atomic<size_t> popped{0};
+};
+
+// --- Inline Definitions ---
+
+template <typename T, size_t Capacity>
+inline bool SpscQueue<T, Capacity>::push(const T &value) {
+    const size_t index = pushed.load(std::memory_order_relaxed);
+    if (index - popped.load(std::memory_order_acquire) == Capacity) return false;
+
+    slots[index % Capacity] = value;
+    pushed.store(index + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T, size_t Capacity>
+inline bool SpscQueue<T, Capacity>::pop(T &value) {
+    const size_t index = popped.load(std::memory_order_relaxed);
+    if (index == pushed.load(std::memory_order_acquire)) return false;
+
+    value = slots[index % Capacity];
+    popped.store(index + 1, std::memory_order_release);
+    return true;
+}
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,464 @@
+#ifndef TILE_BITPLANES_H
+#define TILE_BITPLANES_H
+
+#include "raylib.h"
+#include "tiles.h"
+#include "tile_grid.h"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <array>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+inline size_t lowest_set_bit(uint64_t word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+// Branch-free floor and ceiling for the batched kernels, which avoids a libm call per lookup
+inline long floor_to_long(float value) {
+    auto truncated = static_cast<long>(value);
+    return truncated - (value < static_cast<float>(truncated));
+}
+
+inline long ceil_to_long(float value) {
+    auto truncated = static_cast<long>(value);
+    return truncated + (value > static_cast<float>(truncated));
+}
+
+// Every tile kind an entity hitbox touches, found in one pass
+struct TileContacts {
+    static constexpr size_t MAX_CELLS = 4; // A 1x1 hitbox overlaps at most 2x2 cells
+
+    uint16_t kinds = 0;
+    uint8_t count = 0;
+    LevelCell cells[MAX_CELLS]{};
+    uint8_t cell_kinds[MAX_CELLS]{};
+
+    [[nodiscard]] bool touches(char tile) const;
+    [[nodiscard]] bool find(char tile, LevelCell &cell) const;
+
+    template <uint8_t Traits>
+    [[nodiscard]] bool touches_any() const;
+};
+
+// Outcome of sweeping a 1x1 hitbox along a straight line through the tile grid
+struct SweepResult {
+    bool hit = false;
+    float time = 1.0f;              // Fraction of the move made before touching a tile
+    Vector2 normal = {0.0f, 0.0f};  // Points out of the tile that was hit
+    Vector2 position{};             // End of the move, flush against the tile on a hit
+    LevelCell cell{};               // The tile that was hit
+    int32_t collider = -1;          // The moving collider that was hit instead, if any
+};
+
+// Times at which a 1x1 hitbox moving along one axis starts and stops overlapping a 1x1 box
+// at the given coordinate on that axis. False if it never overlaps it.
+inline bool sweep_slab(float start, float delta, float obstacle, float &entry, float &exit) {
+    // The hitbox overlaps the box while start + delta * t lies strictly inside (obstacle - 1, obstacle + 1)
+    float low  = obstacle - 1.0f;
+    float high = obstacle + 1.0f;
+
+    if (delta == 0.0f) {
+        entry = -std::numeric_limits<float>::infinity();
+        exit  =  std::numeric_limits<float>::infinity();
+        return start > low && start < high;
+    }
+
+    entry = ((delta > 0.0f ? low : high) - start) / delta;
+    exit  = ((delta > 0.0f ? high : low) - start) / delta;
+    return true;
+}
+
+// Spawn markers and dynamic tiles are replaced with air as soon as they are spawned, so they get
+// no plane of their own and are kept in a short list instead
+inline constexpr uint16_t MARKER_KINDS = KINDS_WITH_TRAITS<SPAWN_TRAIT> | KINDS_WITH_TRAITS<DYNAMIC_TRAIT>;
+
+// Tile kind -> its plane, NO_PLANE for air and markers. Planes follow kind order.
+inline constexpr uint8_t NO_PLANE = 0xFF;
+inline constexpr std::array<uint8_t, 16> TILE_KIND_PLANES = [] {
+    std::array<uint8_t, 16> planes{};
+    uint8_t count = 0;
+    for (uint8_t kind = 0; kind < planes.size(); ++kind) {
+        bool live = kind != AIR_TILE && kind < TILE_KIND_COUNT && !((MARKER_KINDS >> kind) & 1);
+        planes[kind] = live ? count++ : NO_PLANE;
+    }
+    return planes;
+}();
+
+// One occupancy bit per cell for every tile kind that stays in a live level. The words of all
+// those kinds covering the same 64 columns of a row sit next to each other, so a query reads
+// a handful of adjacent words no matter how many kinds it is looking for.
+class TileBitplanes {
+public:
+    static constexpr size_t PLANE_COUNT = [] {
+        size_t count = 0;
+        for (uint8_t plane : TILE_KIND_PLANES) count += plane != NO_PLANE;
+        return count;
+    }();
+    // Plane -> its tile kind
+    static constexpr std::array<uint8_t, PLANE_COUNT> PLANE_KINDS = [] {
+        std::array<uint8_t, PLANE_COUNT> kinds{};
+        for (uint8_t kind = 0; kind < TILE_KIND_PLANES.size(); ++kind) {
+            if (TILE_KIND_PLANES[kind] != NO_PLANE) kinds[TILE_KIND_PLANES[kind]] = kind;
+        }
+        return kinds;
+    }();
+
+    TileBitplanes();
+
+    void rebuild(const PackedTileGrid &grid);
+    void set(size_t row_index, size_t column_index, uint8_t old_kind, uint8_t new_kind);
+    // Room for this many markers, so that rebuilding a scrolling window never allocates
+    void reserve_markers(size_t count);
+
+    // Tiles overlapping a 1x1 hitbox at the given position, in row-major order for each kind.
+    // Like overlaps and sweep, it sees no markers; those are spawned before anything moves.
+    [[nodiscard]] TileContacts query(Vector2 position) const;
+
+    // Whether a 1x1 hitbox overlaps any tile with the given traits; only those kinds' planes are read
+    template <uint8_t Traits>
+    [[nodiscard]] bool overlaps(Vector2 position) const;
+
+    // Moves a 1x1 hitbox by delta and reports the first tile with the given traits it would
+    // overlap. Tiles it already overlaps at the start are ignored, so it can always back out.
+    template <uint8_t Traits>
+    [[nodiscard]] SweepResult sweep(Vector2 position, Vector2 delta) const;
+
+    // Branch-free solidity test for batched kernels: whether the given column is solid in either
+    // row a 1x1 hitbox at height y overlaps. Reads a padded per-row bitmap, so columns and rows
+    // off the level need no checks.
+    [[nodiscard]] bool is_solid_column(long column_index, float y) const;
+
+    // Calls visit(row, column, kind) for every cell in the range whose kind has the given traits,
+    // in row-major order for each kind. Air is skipped a whole word at a time. Markers are only
+    // visited when the traits ask for spawn or dynamic tiles, and visit may replace them with air.
+    template <uint8_t Traits, typename Visitor>
+    void for_each(size_t first_row, size_t last_row, size_t first_column, size_t last_column, Visitor &&visit) const;
+
+    [[nodiscard]] size_t get_memory_usage() const;
+
+private:
+    // Inclusive cell range overlapped by a 1x1 hitbox, false if it lies outside the level
+    [[nodiscard]] bool hitbox_range(Vector2 position, size_t &first_row, size_t &last_row,
+                                    size_t &first_column, size_t &last_column) const;
+    [[nodiscard]] static uint64_t column_mask(size_t word_index, size_t first_column, size_t last_column);
+
+    [[nodiscard]] uint64_t solid_bit(long row_index, long column_index) const;
+    void set_solid(size_t row_index, size_t column_index, bool solid);
+
+    [[nodiscard]] uint64_t* words_at(size_t row_index, size_t word_index);
+    [[nodiscard]] const uint64_t* words_at(size_t row_index, size_t word_index) const;
+
+    // Sorted by row, word, kind and column, the order the planes are visited in. A marker replaced
+    // with air stays in the list until the next rebuild, so a for_each over the markers can go on.
+    struct Marker {
+        uint32_t row;
+        uint32_t column;
+        uint8_t kind;
+        bool removed;
+    };
+    [[nodiscard]] static bool marker_before(const Marker &a, const Marker &b);
+    // Where the marker goes in the list, and the marker itself if it is there
+    [[nodiscard]] std::vector<Marker>::iterator marker_slot(size_t row_index, size_t column_index, uint8_t kind);
+    [[nodiscard]] Marker* find_marker(size_t row_index, size_t column_index, uint8_t kind);
+
+    size_t rows;
+    size_t columns;
+    size_t words_per_row;
+    std::vector<uint64_t> planes;
+    std::vector<Marker> markers;
+
+    // Solid tiles only, with an empty row above and below the level and an empty word
+    // on either side of every row
+    size_t solid_words_per_row;
+    std::vector<uint64_t> solid_rows;
+};
+
+// --- Inline Definitions ---
+
+inline bool TileContacts::touches(char tile) const {
+    return kinds & (1u << tile_kind_of(tile));
+}
+
+inline bool TileContacts::find(char tile, LevelCell &cell) const {
+    uint8_t kind = tile_kind_of(tile);
+    for (uint8_t i = 0; i < count; ++i) {
+        if (cell_kinds[i] == kind) {
+            cell = cells[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+template <uint8_t Traits>
+inline bool TileContacts::touches_any() const {
+    return kinds & KINDS_WITH_TRAITS<Traits>;
+}
+
+inline TileBitplanes::TileBitplanes()
+    : rows(0), columns(0), words_per_row(0), solid_words_per_row(2), solid_rows(2 * 2, 0) {}
+
+inline uint64_t* TileBitplanes::words_at(size_t row, size_t word) {
+    return planes.data() + (row * words_per_row + word) * PLANE_COUNT;
+}
+
+inline const uint64_t* TileBitplanes::words_at(size_t row, size_t word) const {
+    return planes.data() + (row * words_per_row + word) * PLANE_COUNT;
+}
+
+inline void TileBitplanes::rebuild(const PackedTileGrid &grid) {
+    rows = grid.get_rows();
+    columns = grid.get_columns();
+    words_per_row = (columns + 63) / 64;
+    planes.assign(rows * words_per_row * PLANE_COUNT, 0);
+    solid_words_per_row = words_per_row + 2;
+    solid_rows.assign((rows + 2) * solid_words_per_row, 0);
+    markers.clear();
+
+    for (size_t row = 0; row < rows; ++row) {
+        for (size_t column = 0; column < columns; ++column) {
+            if (uint8_t kind = grid.get_kind(row, column); kind != AIR_TILE) {
+                if (uint8_t plane = TILE_KIND_PLANES[kind]; plane != NO_PLANE) {
+                    words_at(row, column / 64)[plane] |= uint64_t{1} << (column % 64);
+                } else {
+                    markers.push_back({static_cast<uint32_t>(row), static_cast<uint32_t>(column), kind, false});
+                }
+                if (TILE_KIND_TRAITS[kind] & SOLID_TRAIT) set_solid(row, column, true);
+            }
+        }
+    }
+    std::sort(markers.begin(), markers.end(), marker_before);
+}
+
+inline void TileBitplanes::reserve_markers(size_t count) {
+    markers.reserve(count);
+}
+
+inline bool TileBitplanes::marker_before(const Marker &a, const Marker &b) {
+    if (a.row != b.row) return a.row < b.row;
+    if (a.column / 64 != b.column / 64) return a.column / 64 < b.column / 64;
+    if (a.kind != b.kind) return a.kind < b.kind;
+    return a.column < b.column;
+}
+
+inline std::vector<TileBitplanes::Marker>::iterator TileBitplanes::marker_slot(size_t row, size_t column, uint8_t kind) {
+    Marker key{static_cast<uint32_t>(row), static_cast<uint32_t>(column), kind, false};
+    return std::lower_bound(markers.begin(), markers.end(), key, marker_before);
+}
+
+inline TileBitplanes::Marker* TileBitplanes::find_marker(size_t row, size_t column, uint8_t kind) {
+    auto slot = marker_slot(row, column, kind);
+    bool found = slot != markers.end() && slot->row == row && slot->column == column && slot->kind == kind;
+    return found ? &*slot : nullptr;
+}
+
+inline void TileBitplanes::set_solid(size_t row, size_t column, bool solid) {
+    uint64_t &word = solid_rows[(row + 1) * solid_words_per_row + column / 64 + 1];
+    uint64_t bit = uint64_t{1} << (column % 64);
+    word = solid ? word | bit : word & ~bit;
+}
+
+inline uint64_t TileBitplanes::solid_bit(long row, long column) const {
+    // Clamp into the padding, which is always empty
+    row = std::min(std::max(row, -1L), static_cast<long>(rows));
+    column = std::min(std::max(column, -1L), static_cast<long>(columns));
+    size_t bit = static_cast<size_t>(column + 64);
+    return (solid_rows[(row + 1) * solid_words_per_row + bit / 64] >> (bit % 64)) & 1;
+}
+
+inline bool TileBitplanes::is_solid_column(long column, float y) const {
+    // The rows a 1x1 hitbox overlaps: the floor and ceiling of its y
+    return (solid_bit(floor_to_long(y), column) | solid_bit(ceil_to_long(y), column)) != 0;
+}
+
+inline void TileBitplanes::set(size_t row, size_t column, uint8_t old_kind, uint8_t new_kind) {
+    uint64_t *words = words_at(row, column / 64);
+    uint64_t bit = uint64_t{1} << (column % 64);
+
+    if (TILE_KIND_PLANES[old_kind] != NO_PLANE) {
+        words[TILE_KIND_PLANES[old_kind]] &= ~bit;
+    } else if (old_kind != AIR_TILE) {
+        if (Marker *marker = find_marker(row, column, old_kind)) marker->removed = true;
+    }
+
+    if (TILE_KIND_PLANES[new_kind] != NO_PLANE) {
+        words[TILE_KIND_PLANES[new_kind]] |= bit;
+    } else if (new_kind != AIR_TILE) {
+        if (Marker *marker = find_marker(row, column, new_kind)) {
+            marker->removed = false;
+        } else {
+            markers.insert(marker_slot(row, column, new_kind),
+                           {static_cast<uint32_t>(row), static_cast<uint32_t>(column), new_kind, false});
+        }
+    }
+    set_solid(row, column, TILE_KIND_TRAITS[new_kind] & SOLID_TRAIT);
+}
+
+inline bool TileBitplanes::hitbox_range(Vector2 pos, size_t &first_row, size_t &last_row,
+                                        size_t &first_column, size_t &last_column) const {
+    // Cells overlapping [x, x + 1) x [y, y + 1), clipped to the level
+    long low_row     = std::max(0L, static_cast<long>(std::floor(pos.y)));
+    long high_row    = std::min(static_cast<long>(rows) - 1, static_cast<long>(std::ceil(pos.y)));
+    long low_column  = std::max(0L, static_cast<long>(std::floor(pos.x)));
+    long high_column = std::min(static_cast<long>(columns) - 1, static_cast<long>(std::ceil(pos.x)));
+    if (low_row > high_row || low_column > high_column) return false;
+
+    first_row = low_row;
+    last_row = high_row;
+    first_column = low_column;
+    last_column = high_column;
+    return true;
+}
+
+inline uint64_t TileBitplanes::column_mask(size_t word, size_t first_column, size_t last_column) {
+    // Bits of this word that fall between first_column and last_column
+    size_t low  = word == first_column / 64 ? first_column % 64 : 0;
+    size_t high = word == last_column / 64 ? last_column % 64 : 63;
+    return (~uint64_t{0} >> (63 - high)) & (~uint64_t{0} << low);
+}
+
+inline TileContacts TileBitplanes::query(Vector2 pos) const {
+    TileContacts contacts;
+    size_t first_row, last_row, first_column, last_column;
+    if (!hitbox_range(pos, first_row, last_row, first_column, last_column)) return contacts;
+
+    for (size_t row = first_row; row <= last_row; ++row) {
+        for (size_t word = first_column / 64; word <= last_column / 64; ++word) {
+            uint64_t mask = column_mask(word, first_column, last_column);
+
+            const uint64_t *words = words_at(row, word);
+            for (size_t plane = 0; plane < PLANE_COUNT; ++plane) {
+                for (uint64_t hits = words[plane] & mask; hits != 0; hits &= hits - 1) {
+                    uint8_t kind = PLANE_KINDS[plane];
+                    contacts.kinds |= 1u << kind;
+                    contacts.cells[contacts.count] = {row, word * 64 + lowest_set_bit(hits)};
+                    contacts.cell_kinds[contacts.count] = kind;
+                    ++contacts.count;
+                }
+            }
+        }
+    }
+    return contacts;
+}
+
+template <uint8_t Traits>
+inline bool TileBitplanes::overlaps(Vector2 pos) const {
+    constexpr uint16_t KINDS = KINDS_WITH_TRAITS<Traits>;
+    size_t first_row, last_row, first_column, last_column;
+    if (!hitbox_range(pos, first_row, last_row, first_column, last_column)) return false;
+
+    uint64_t hits = 0;
+    for (size_t row = first_row; row <= last_row; ++row) {
+        for (size_t word = first_column / 64; word <= last_column / 64; ++word) {
+            const uint64_t *words = words_at(row, word);
+
+            // KINDS is a constant, so this folds into an OR of the matching planes
+            uint64_t occupied = 0;
+            for (size_t plane = 0; plane < PLANE_COUNT; ++plane) {
+                occupied |= words[plane] & (0 - static_cast<uint64_t>((KINDS >> PLANE_KINDS[plane]) & 1));
+            }
+            hits |= occupied & column_mask(word, first_column, last_column);
+        }
+    }
+    return hits != 0;
+}
+
+template <uint8_t Traits>
+inline SweepResult TileBitplanes::sweep(Vector2 pos, Vector2 delta) const {
+    SweepResult result;
+    result.position = {pos.x + delta.x, pos.y + delta.y};
+
+    // Only the cells inside the box swept by the move can be hit
+    float low_x  = std::min(pos.x, result.position.x), high_x = std::max(pos.x, result.position.x);
+    float low_y  = std::min(pos.y, result.position.y), high_y = std::max(pos.y, result.position.y);
+    if (high_x + 1.0f <= 0.0f || high_y + 1.0f <= 0.0f) return result;
+    size_t first_column = low_x > 0.0f ? static_cast<size_t>(std::floor(low_x)) : 0;
+    size_t first_row    = low_y > 0.0f ? static_cast<size_t>(std::floor(low_y)) : 0;
+    auto last_column    = static_cast<size_t>(std::ceil(high_x));
+    auto last_row       = static_cast<size_t>(std::ceil(high_y));
+
+    bool along_x = false;
+    for_each<Traits>(first_row, last_row, first_column, last_column, [&](size_t row, size_t column, uint8_t) {
+        float entry_x, exit_x, entry_y, exit_y;
+        if (!sweep_slab(pos.x, delta.x, static_cast<float>(column), entry_x, exit_x)) return;
+        if (!sweep_slab(pos.y, delta.y, static_cast<float>(row), entry_y, exit_y)) return;
+
+        float entry = std::max(entry_x, entry_y);
+        float exit  = std::min(exit_x, exit_y);
+        if (entry < 0.0f || entry >= exit || entry >= 1.0f) return;
+        if (result.hit && entry >= result.time) return;
+
+        result.hit  = true;
+        result.time = entry;
+        result.cell = {row, column};
+        along_x     = entry_x > entry_y;
+    });
+    if (!result.hit) return result;
+
+    // Land exactly against the tile instead of trusting the interpolated position
+    if (along_x) {
+        result.normal   = {delta.x > 0.0f ? -1.0f : 1.0f, 0.0f};
+        result.position = {static_cast<float>(result.cell.column) + result.normal.x, pos.y + delta.y * result.time};
+    } else {
+        result.normal   = {0.0f, delta.y > 0.0f ? -1.0f : 1.0f};
+        result.position = {pos.x + delta.x * result.time, static_cast<float>(result.cell.row) + result.normal.y};
+    }
+    return result;
+}
+
+template <uint8_t Traits, typename Visitor>
+inline void TileBitplanes::for_each(size_t first_row, size_t last_row, size_t first_column, size_t last_column,
+                                    Visitor &&visit) const {
+    constexpr uint16_t KINDS = KINDS_WITH_TRAITS<Traits>;
+    last_row = std::min(last_row, rows - 1);
+    last_column = std::min(last_column, columns - 1);
+    if (rows == 0 || columns == 0 || first_row > last_row || first_column > last_column) return;
+
+    if constexpr ((Traits & (SPAWN_TRAIT | DYNAMIC_TRAIT)) != 0) {
+        // Only markers have these traits
+        for (size_t row = first_row; row <= last_row; ++row) {
+            Marker first{static_cast<uint32_t>(row), static_cast<uint32_t>(first_column), 0, false};
+            auto marker = std::lower_bound(markers.cbegin(), markers.cend(), first, marker_before);
+            for (; marker != markers.cend() && marker->row == row && marker->column / 64 <= last_column / 64; ++marker) {
+                if (marker->removed || !((KINDS >> marker->kind) & 1)) continue;
+                if (marker->column < first_column || marker->column > last_column) continue;
+                visit(row, static_cast<size_t>(marker->column), marker->kind);
+            }
+        }
+        return;
+    }
+
+    for (size_t row = first_row; row <= last_row; ++row) {
+        for (size_t word = first_column / 64; word <= last_column / 64; ++word) {
+            uint64_t mask = column_mask(word, first_column, last_column);
+            const uint64_t *words = words_at(row, word);
+
+            for (size_t plane = 0; plane < PLANE_COUNT; ++plane) {
+                if (!((KINDS >> PLANE_KINDS[plane]) & 1)) continue;
+                for (uint64_t hits = words[plane] & mask; hits != 0; hits &= hits - 1) {
+                    visit(row, word * 64 + lowest_set_bit(hits), PLANE_KINDS[plane]);
+                }
+            }
+        }
+    }
+}
+
+inline size_t TileBitplanes::get_memory_usage() const {
+    return sizeof(*this) + (planes.capacity() + solid_rows.capacity()) * sizeof(uint64_t) +
+           markers.capacity() * sizeof(Marker);
+}
+
+#endif // TILE_BITPLANES_H
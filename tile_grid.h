@@ -0,0 +1,209 @@
+#ifndef TILE_GRID_H
+#define TILE_GRID_H
+
+#include "tiles.h"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+// Live level storage: two tiles per byte, row-major, every row starting on a byte boundary
+class PackedTileGrid {
+public:
+    PackedTileGrid();
+    PackedTileGrid(size_t row_count, size_t column_count, char fill = AIR);
+
+    [[nodiscard]] size_t get_rows() const;
+    [[nodiscard]] size_t get_columns() const;
+
+    [[nodiscard]] uint8_t get_kind(size_t row_index, size_t column_index) const;
+    [[nodiscard]] char get(size_t row_index, size_t column_index) const;
+    void set(size_t row_index, size_t column_index, char tile);
+    void fill_run(size_t row_index, size_t first_column, size_t count, char tile);
+
+    // Scrolling: drops the first columns, moving the rest left, then writes another grid
+    // of the same height over the columns starting at first_column
+    void shift_left(size_t count);
+    void copy_columns(const PackedTileGrid &source, size_t first_column);
+
+    [[nodiscard]] size_t get_memory_usage() const;
+
+private:
+    size_t rows;
+    size_t columns;
+    size_t stride;
+    std::vector<uint8_t> cells;
+};
+
+// Level template storage: each row is a list of runs, indexed per row so any cell
+// can still be looked up in O(log runs) without unpacking the whole level
+class CompressedTileGrid {
+public:
+    CompressedTileGrid();
+
+    [[nodiscard]] size_t get_rows() const;
+    [[nodiscard]] size_t get_columns() const;
+
+    // Building, row by row
+    void append_run(char tile, size_t count);
+    [[nodiscard]] size_t get_pending_row_length() const;
+    void end_row();
+
+    [[nodiscard]] char get(size_t row_index, size_t column_index) const;
+    void unpack_into(PackedTileGrid &grid) const;
+
+    [[nodiscard]] size_t get_run_count() const;
+    [[nodiscard]] size_t get_memory_usage() const;
+
+private:
+    size_t columns;
+    size_t pending_row_length;
+    std::vector<uint32_t> row_starts;  // First run of every row, plus one past the last run
+    std::vector<uint32_t> run_ends;    // Column one past the end of each run
+    std::vector<uint8_t>  run_kinds;
+};
+
+// --- Inline Definitions ---
+
+inline PackedTileGrid::PackedTileGrid()
+    : rows(0), columns(0), stride(0) {}
+
+inline PackedTileGrid::PackedTileGrid(size_t row_count, size_t column_count, char fill)
+    : rows(row_count), columns(column_count), stride((column_count + 1) / 2) {
+    uint8_t kind = tile_kind_of(fill);
+    cells.assign(rows * stride, static_cast<uint8_t>(kind | (kind << 4)));
+}
+
+inline size_t PackedTileGrid::get_rows() const {
+    return rows;
+}
+
+inline size_t PackedTileGrid::get_columns() const {
+    return columns;
+}
+
+inline uint8_t PackedTileGrid::get_kind(size_t row, size_t column) const {
+    uint8_t pair = cells[row * stride + column / 2];
+    return (pair >> ((column & 1) * 4)) & 0x0F;
+}
+
+inline char PackedTileGrid::get(size_t row, size_t column) const {
+    return TILE_CHARS[get_kind(row, column)];
+}
+
+inline void PackedTileGrid::set(size_t row, size_t column, char tile) {
+    uint8_t &pair = cells[row * stride + column / 2];
+    unsigned shift = (column & 1) * 4;
+    pair = static_cast<uint8_t>((pair & ~(0x0F << shift)) | (tile_kind_of(tile) << shift));
+}
+
+inline void PackedTileGrid::fill_run(size_t row, size_t column, size_t count, char tile) {
+    size_t end = column + count;
+
+    // Write the odd edges one nibble at a time and the middle a byte at a time
+    if (column < end && (column & 1)) set(row, column++, tile);
+    if (column < end && (end & 1)) set(row, --end, tile);
+
+    uint8_t kind = tile_kind_of(tile);
+    uint8_t *first = cells.data() + row * stride + column / 2;
+    std::fill(first, first + (end - column) / 2, static_cast<uint8_t>(kind | (kind << 4)));
+}
+
+inline void PackedTileGrid::shift_left(size_t count) {
+    count = std::min(count, columns);
+    for (size_t row = 0; row < rows; ++row) {
+        uint8_t *first = cells.data() + row * stride;
+        if (count % 2 == 0) {
+            // Whole bytes move, so the row is a single memmove
+            std::copy(first + count / 2, first + stride, first);
+        } else {
+            for (size_t column = 0; column + count < columns; ++column) {
+                set(row, column, get(row, column + count));
+            }
+        }
+        fill_run(row, columns - count, count, AIR);
+    }
+}
+
+inline void PackedTileGrid::copy_columns(const PackedTileGrid &source, size_t first_column) {
+    const size_t count = std::min(source.columns, columns - std::min(first_column, columns));
+    for (size_t row = 0; row < rows && row < source.rows; ++row) {
+        if (first_column % 2 == 0 && count % 2 == 0) {
+            const uint8_t *from = source.cells.data() + row * source.stride;
+            std::copy(from, from + count / 2, cells.data() + row * stride + first_column / 2);
+        } else {
+            for (size_t column = 0; column < count; ++column) {
+                set(row, first_column + column, source.get(row, column));
+            }
+        }
+    }
+}
+
+inline size_t PackedTileGrid::get_memory_usage() const {
+    return sizeof(*this) + cells.capacity();
+}
+
+inline CompressedTileGrid::CompressedTileGrid()
+    : columns(0), pending_row_length(0), row_starts{0} {}
+
+inline size_t CompressedTileGrid::get_rows() const {
+    return row_starts.size() - 1;
+}
+
+inline size_t CompressedTileGrid::get_columns() const {
+    return columns;
+}
+
+inline void CompressedTileGrid::append_run(char tile, size_t count) {
+    if (count == 0) return;
+    pending_row_length += count;
+
+    // Merge with the previous run of the same row if it is the same tile
+    uint8_t kind = tile_kind_of(tile);
+    if (run_kinds.size() > row_starts.back() && run_kinds.back() == kind) {
+        run_ends.back() = static_cast<uint32_t>(pending_row_length);
+        return;
+    }
+    run_ends.push_back(static_cast<uint32_t>(pending_row_length));
+    run_kinds.push_back(kind);
+}
+
+inline size_t CompressedTileGrid::get_pending_row_length() const {
+    return pending_row_length;
+}
+
+inline void CompressedTileGrid::end_row() {
+    if (get_rows() == 0) columns = pending_row_length;
+    row_starts.push_back(static_cast<uint32_t>(run_ends.size()));
+    pending_row_length = 0;
+}
+
+inline char CompressedTileGrid::get(size_t row, size_t column) const {
+    auto first = run_ends.begin() + row_starts[row];
+    auto last  = run_ends.begin() + row_starts[row + 1];
+    auto run   = std::upper_bound(first, last, static_cast<uint32_t>(column));
+    return TILE_CHARS[run_kinds[run - run_ends.begin()]];
+}
+
+inline void CompressedTileGrid::unpack_into(PackedTileGrid &grid) const {
+    for (size_t row = 0; row < get_rows(); ++row) {
+        size_t column = 0;
+        for (size_t run = row_starts[row]; run < row_starts[row + 1]; ++run) {
+            grid.fill_run(row, column, run_ends[run] - column, TILE_CHARS[run_kinds[run]]);
+            column = run_ends[run];
+        }
+    }
+}
+
+inline size_t CompressedTileGrid::get_run_count() const {
+    return run_ends.size();
+}
+
+inline size_t CompressedTileGrid::get_memory_usage() const {
+    return sizeof(*this) +
+           row_starts.capacity() * sizeof(uint32_t) +
+           run_ends.capacity() * sizeof(uint32_t) +
+           run_kinds.capacity();
+}
+
+#endif // TILE_GRID_H
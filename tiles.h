@@ -0,0 +1,128 @@
+#ifndef TILES_H
+#define TILES_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+/* Game Elements */
+
+inline const char WALL      = '#',
+                  WALL_DARK = '=',
+                  AIR       = '-',
+                  SPIKE     = '^',
+                  PLAYER    = '@',
+                  ENEMY     = '&',
+                  CHASER    = 'c',
+                  COIN      = '*',
+                  EXIT      = 'E';
+
+// Moving colliders, taken off the grid on load and simulated separately
+inline const char MOVING_PLATFORM = '~',
+                  FALLING_BLOCK   = '%',
+                  MOVING_SPIKE    = 'v';
+
+/* Compact Tile Codes */
+
+// Every tile kind fits in a nibble, which is how the packed level grids store them
+enum tile_kind : uint8_t {
+    AIR_TILE,
+    WALL_TILE,
+    WALL_DARK_TILE,
+    SPIKE_TILE,
+    PLAYER_TILE,
+    ENEMY_TILE,
+    COIN_TILE,
+    EXIT_TILE,
+    MOVING_PLATFORM_TILE,
+    FALLING_BLOCK_TILE,
+    MOVING_SPIKE_TILE,
+    CHASER_TILE,
+    TILE_KIND_COUNT
+};
+
+inline const uint8_t INVALID_TILE = 0xFF;
+
+// Tile kind -> level character (unused nibble values read back as air)
+inline constexpr std::array<char, 16> TILE_CHARS = {
+    AIR, WALL, WALL_DARK, SPIKE, PLAYER, ENEMY, COIN, EXIT,
+    MOVING_PLATFORM, FALLING_BLOCK, MOVING_SPIKE, CHASER, AIR, AIR, AIR, AIR
+};
+
+// Level character -> tile kind, INVALID_TILE for characters that are not tiles
+inline constexpr std::array<uint8_t, 256> TILE_KINDS = [] {
+    std::array<uint8_t, 256> kinds{};
+    for (auto &kind : kinds) kind = INVALID_TILE;
+    for (uint8_t kind = 0; kind < TILE_KIND_COUNT; ++kind) {
+        kinds[static_cast<unsigned char>(TILE_CHARS[kind])] = kind;
+    }
+    return kinds;
+}();
+
+inline uint8_t tile_kind_of(const char tile) {
+    return TILE_KINDS[static_cast<unsigned char>(tile)];
+}
+
+inline bool is_tile_char(const char tile) {
+    return tile_kind_of(tile) != INVALID_TILE;
+}
+
+/* Tile Traits */
+
+enum tile_trait : uint8_t {
+    SOLID_TRAIT       = 1 << 0, // Blocks movement
+    LETHAL_TRAIT      = 1 << 1, // Kills the player on touch
+    COLLECTIBLE_TRAIT = 1 << 2, // Picked up by the player
+    GOAL_TRAIT        = 1 << 3, // Ends the level
+    IMAGE_TRAIT       = 1 << 4, // Drawn with a static texture
+    SPRITE_TRAIT      = 1 << 5, // Drawn with an animated sprite
+    SPAWN_TRAIT       = 1 << 6, // Marks where an entity starts, replaced with air on load
+    DYNAMIC_TRAIT     = 1 << 7  // Turns into a moving collider with the other traits, replaced with air on load
+};
+
+// Indexed by tile kind; adding a tile kind only needs a row here
+inline constexpr std::array<uint8_t, 16> TILE_KIND_TRAITS = {
+    /* AIR       */ 0,
+    /* WALL      */ SOLID_TRAIT | IMAGE_TRAIT,
+    /* WALL_DARK */ IMAGE_TRAIT, // Background scenery, walked in front of
+    /* SPIKE     */ LETHAL_TRAIT | IMAGE_TRAIT,
+    /* PLAYER    */ SPAWN_TRAIT,
+    /* ENEMY     */ SPAWN_TRAIT,
+    /* COIN      */ COLLECTIBLE_TRAIT | SPRITE_TRAIT,
+    /* EXIT      */ GOAL_TRAIT | IMAGE_TRAIT,
+    /* PLATFORM  */ DYNAMIC_TRAIT | SOLID_TRAIT | IMAGE_TRAIT,
+    /* FALLING   */ DYNAMIC_TRAIT | SOLID_TRAIT | IMAGE_TRAIT,
+    /* M. SPIKE  */ DYNAMIC_TRAIT | LETHAL_TRAIT | IMAGE_TRAIT,
+    /* CHASER    */ SPAWN_TRAIT
+};
+
+// Indexed by the tile byte as it appears in the level files
+inline constexpr std::array<uint8_t, 256> TILE_TRAITS = [] {
+    std::array<uint8_t, 256> traits{};
+    for (size_t tile = 0; tile < traits.size(); ++tile) {
+        if (TILE_KINDS[tile] != INVALID_TILE) traits[tile] = TILE_KIND_TRAITS[TILE_KINDS[tile]];
+    }
+    return traits;
+}();
+
+// One bit per tile kind that has all of the given traits, folded at compile time
+template <uint8_t Traits>
+inline constexpr uint16_t KINDS_WITH_TRAITS = [] {
+    uint16_t kinds = 0;
+    for (uint8_t kind = 0; kind < TILE_KIND_COUNT; ++kind) {
+        if ((TILE_KIND_TRAITS[kind] & Traits) == Traits) kinds |= 1u << kind;
+    }
+    return kinds;
+}();
+
+template <uint8_t Traits>
+inline bool tile_has_traits(const char tile) {
+    return (TILE_TRAITS[static_cast<unsigned char>(tile)] & Traits) == Traits;
+}
+
+struct LevelCell {
+    size_t row;
+    size_t column;
+};
+
+#endif // TILES_H
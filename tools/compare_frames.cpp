@@ -0,0 +1,139 @@
+// Compares the PNGs the game captured against golden images of the same name.
+//
+//   compare_frames GOLDEN_DIR CAPTURE_DIR [options]
+//     --tolerance N     largest difference of a channel that still counts as equal, 0 to 255 (default 8)
+//     --max-differing F share of the pixels allowed to differ, 0 to 1 (default 0.001)
+//
+// Every golden image needs a capture of the same size. For each mismatch a NAME.diff.png is
+// written next to the capture, showing the differing pixels in red over a faded golden image.
+// Exits with 1 if any image does not match.
+
+#include "raylib.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct compare_options {
+    int tolerance = 8;
+    double max_differing = 0.001;
+};
+
+struct compare_result {
+    bool matches;
+    size_t differing;
+    size_t pixels;
+    std::string problem; // Set when the images could not be compared at all
+};
+
+bool channel_differs(unsigned char golden, unsigned char captured, int tolerance) {
+    return std::abs(static_cast<int>(golden) - static_cast<int>(captured)) > tolerance;
+}
+
+compare_result compare_images(const std::string &golden_path, const std::string &capture_path,
+                              const std::string &diff_path, const compare_options &options) {
+    if (!std::filesystem::exists(capture_path)) return {false, 0, 0, "no capture"};
+
+    Image golden = LoadImage(golden_path.c_str());
+    Image captured = LoadImage(capture_path.c_str());
+    if (golden.data == nullptr || captured.data == nullptr) {
+        UnloadImage(golden);
+        UnloadImage(captured);
+        return {false, 0, 0, "could not be read"};
+    }
+    if (golden.width != captured.width || golden.height != captured.height) {
+        compare_result result = {false, 0, 0, "captured at " + std::to_string(captured.width) + "x" + std::to_string(captured.height) +
+                                              ", golden is " + std::to_string(golden.width) + "x" + std::to_string(golden.height)};
+        UnloadImage(golden);
+        UnloadImage(captured);
+        return result;
+    }
+
+    Color *golden_pixels = LoadImageColors(golden);
+    Color *captured_pixels = LoadImageColors(captured);
+    const size_t pixels = static_cast<size_t>(golden.width) * static_cast<size_t>(golden.height);
+
+    // The diff reuses the golden pixels
+    size_t differing = 0;
+    for (size_t i = 0; i < pixels; ++i) {
+        const Color &expected = golden_pixels[i];
+        const Color &actual = captured_pixels[i];
+        const bool differs = channel_differs(expected.r, actual.r, options.tolerance) ||
+                             channel_differs(expected.g, actual.g, options.tolerance) ||
+                             channel_differs(expected.b, actual.b, options.tolerance) ||
+                             channel_differs(expected.a, actual.a, options.tolerance);
+        differing += differs;
+        golden_pixels[i] = differs ? RED : Color{static_cast<unsigned char>(expected.r / 4), static_cast<unsigned char>(expected.g / 4),
+                                                 static_cast<unsigned char>(expected.b / 4), 255};
+    }
+
+    const bool matches = static_cast<double>(differing) <= options.max_differing * static_cast<double>(pixels);
+    if (!matches) {
+        Image diff = {golden_pixels, golden.width, golden.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+        ExportImage(diff, diff_path.c_str());
+    }
+
+    UnloadImageColors(golden_pixels);
+    UnloadImageColors(captured_pixels);
+    UnloadImage(golden);
+    UnloadImage(captured);
+    return {matches, differing, pixels, ""};
+}
+
+int main(int argc, char **argv) {
+    const char *usage = "Usage: compare_frames GOLDEN_DIR CAPTURE_DIR [--tolerance N] [--max-differing F]\n";
+    if (argc < 3) {
+        std::cerr << usage;
+        return 1;
+    }
+    const std::filesystem::path golden_directory = argv[1];
+    const std::filesystem::path capture_directory = argv[2];
+
+    compare_options options;
+    std::vector<std::filesystem::path> goldens;
+    try {
+        for (int i = 3; i < argc; ++i) {
+            const std::string argument = argv[i];
+            if (i + 1 >= argc) throw std::runtime_error("Missing value for " + argument);
+            if (argument == "--tolerance") options.tolerance = std::stoi(argv[++i]);
+            else if (argument == "--max-differing") options.max_differing = std::stod(argv[++i]);
+            else throw std::runtime_error("Unknown option: " + argument);
+        }
+
+        for (const auto &entry : std::filesystem::directory_iterator(golden_directory)) {
+            if (entry.path().extension() == ".png") goldens.push_back(entry.path());
+        }
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << '\n' << usage;
+        return 1;
+    }
+    if (goldens.empty()) {
+        std::cerr << "No golden images in " << golden_directory.string() << '\n';
+        return 1;
+    }
+    std::sort(goldens.begin(), goldens.end());
+
+    SetTraceLogLevel(LOG_WARNING);
+    size_t failures = 0;
+    for (const std::filesystem::path &golden : goldens) {
+        const std::filesystem::path capture = capture_directory / golden.filename();
+        const std::filesystem::path diff = capture_directory / (golden.stem().string() + ".diff.png");
+        const compare_result result = compare_images(golden.string(), capture.string(), diff.string(), options);
+
+        if (!result.problem.empty()) {
+            std::printf("%-24s FAIL  %s\n", golden.filename().string().c_str(), result.problem.c_str());
+        } else {
+            std::printf("%-24s %s  %zu of %zu pixels differ\n", golden.filename().string().c_str(),
+                        result.matches ? "ok  " : "FAIL", result.differing, result.pixels);
+        }
+        failures += !result.matches;
+    }
+
+    std::printf("%zu of %zu frames match\n", goldens.size() - failures, goldens.size());
+    return failures == 0 ? 0 : 1;
+}
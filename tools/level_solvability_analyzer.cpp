@@ -0,0 +1,340 @@
+// Checks that every level in a .rll file can be finished in time, before it ships.
+//
+//   level_solvability_analyzer [levels.rll] [--threads N]
+//
+// Runs a breadth-first search over the player's states, one frame per layer, using the
+// movement rules of Player::move_player_horizontally and Player::update_player_gravity.
+// States are discretized to the grid the physics moves on: tenths of a tile across,
+// hundredths of a tile down, and hundredths of a tile per frame of vertical velocity.
+// Each layer is expanded by all threads at once into a shared lock-free visited set.
+//
+// The first layer that touches the exit is the fastest completion. Coins no state ever
+// touches are reported as unreachable. Enemies are left out, since they can be stomped,
+// and so are moving colliders, which are assumed to be out of the way.
+//
+// Exits with 1 if any level cannot be finished within MAX_LEVEL_TIME.
+
+#include "level_controller.h"
+#include "level.h"
+#include "globals.h"
+#include "graphics.h"
+#include "assets.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Discretized Player States */
+
+// Fixed-point units of a state, and the offsets that keep them positive inside a key
+const float X_UNITS = 10.0f;
+const float Y_UNITS = 100.0f;
+const float VELOCITY_UNITS = 100.0f;
+const int64_t X_OFFSET = 1 << 10, Y_OFFSET = 1 << 12, VELOCITY_OFFSET = 1 << 11;
+const int X_BITS = 24, Y_BITS = 16, VELOCITY_BITS = 12;
+
+struct player_state {
+    Vector2 pos;
+    float y_velocity;
+    bool on_ground;
+};
+
+uint64_t pack_state(const player_state &state) {
+    const auto x = static_cast<uint64_t>(std::lround(state.pos.x * X_UNITS) + X_OFFSET);
+    const auto y = static_cast<uint64_t>(std::lround(state.pos.y * Y_UNITS) + Y_OFFSET);
+    const auto velocity = static_cast<uint64_t>(std::lround(state.y_velocity * VELOCITY_UNITS) + VELOCITY_OFFSET);
+    return (((x << Y_BITS | y) << VELOCITY_BITS | velocity) << 1) | state.on_ground;
+}
+
+player_state unpack_state(uint64_t key) {
+    player_state state{};
+    state.on_ground = key & 1;
+    key >>= 1;
+    state.y_velocity = static_cast<float>(static_cast<int64_t>(key & ((1 << VELOCITY_BITS) - 1)) - VELOCITY_OFFSET) / VELOCITY_UNITS;
+    key >>= VELOCITY_BITS;
+    state.pos.y = static_cast<float>(static_cast<int64_t>(key & ((1 << Y_BITS) - 1)) - Y_OFFSET) / Y_UNITS;
+    key >>= Y_BITS;
+    state.pos.x = static_cast<float>(static_cast<int64_t>(key) - X_OFFSET) / X_UNITS;
+    return state;
+}
+
+// Open addressing over packed states, inserted into from every thread at once. Grown between
+// layers only, when no thread is inserting, so inserts never have to coordinate a resize.
+class visited_states {
+public:
+    // Makes room for extra more states at under half load
+    void reserve(size_t extra) {
+        size_t needed = (count.load() + extra) * 2;
+        if (needed <= capacity) return;
+
+        size_t new_capacity = std::max<size_t>(capacity, 1 << 16);
+        while (new_capacity < needed) new_capacity *= 2;
+
+        std::unique_ptr<std::atomic<uint64_t>[]> old_slots = std::move(slots);
+        size_t old_capacity = capacity;
+        slots = std::make_unique<std::atomic<uint64_t>[]>(new_capacity);
+        capacity = new_capacity;
+        for (size_t i = 0; i < capacity; ++i) slots[i].store(0, std::memory_order_relaxed);
+        count.store(0);
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (uint64_t slot = old_slots[i].load(std::memory_order_relaxed)) insert(slot - 1);
+        }
+    }
+
+    // Whether the state was new
+    bool insert(uint64_t key) {
+        const uint64_t stored = key + 1; // 0 marks an empty slot
+        for (size_t i = mix(key) & (capacity - 1);; i = (i + 1) & (capacity - 1)) {
+            uint64_t slot = slots[i].load(std::memory_order_relaxed);
+            if (slot == stored) return false;
+            if (slot == 0) {
+                if (slots[i].compare_exchange_strong(slot, stored, std::memory_order_relaxed)) {
+                    count.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+                if (slot == stored) return false;
+            }
+        }
+    }
+
+    [[nodiscard]] size_t size() const {
+        return count.load();
+    }
+
+private:
+    static uint64_t mix(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xFF51AFD7ED558CCDull;
+        key ^= key >> 33;
+        return key;
+    }
+
+    std::unique_ptr<std::atomic<uint64_t>[]> slots;
+    size_t capacity = 0;
+    std::atomic<size_t> count{0};
+};
+
+/* Search */
+
+struct level_report {
+    size_t columns = 0;
+    size_t rows = 0;
+    long exit_frame = -1;      // First frame the exit can be touched on, or -1
+    size_t explored_states = 0;
+    std::vector<LevelCell> unreachable_coins;
+    size_t coin_count = 0;
+    double seconds = 0.0;
+};
+
+// Layers smaller than this are expanded on the calling thread; starting workers would cost more
+const size_t PARALLEL_LAYER_SIZE = 4096;
+const size_t LAYER_BLOCK = 256;
+
+class level_analyzer {
+public:
+    level_analyzer(const CompressedTileGrid &source, size_t thread_count)
+        : threads(std::max<size_t>(thread_count, 1)) {
+        level.load_from(source);
+        report.rows = level.get_rows();
+        report.columns = level.get_columns();
+        if ((report.columns * X_UNITS) + X_OFFSET >= (1 << X_BITS) || (report.rows * Y_UNITS) + Y_OFFSET >= (1 << Y_BITS)) {
+            throw std::runtime_error("Level too large to analyze");
+        }
+
+        // Spawn markers and moving colliders leave nothing behind in the level
+        bool found_player = false;
+        for (size_t row = 0; row < report.rows; ++row) {
+            for (size_t column = 0; column < report.columns; ++column) {
+                uint8_t kind = tile_kind_of(level.get_cell(row, column));
+                if (kind == PLAYER_TILE && !found_player) {
+                    start = {{static_cast<float>(column), static_cast<float>(row)}, 0.0f, false};
+                    found_player = true;
+                }
+                if (TILE_KIND_TRAITS[kind] & (SPAWN_TRAIT | DYNAMIC_TRAIT)) level.set_cell(row, column, AIR);
+                if (kind == COIN_TILE) ++report.coin_count;
+            }
+        }
+        if (!found_player) throw std::runtime_error("Level has no player");
+
+        start.on_ground = level.get_bitplanes().overlaps<SOLID_TRAIT>({start.pos.x, start.pos.y + GROUND_SNAP_DISTANCE});
+        coins_reached = std::make_unique<std::atomic<uint8_t>[]>(report.rows * report.columns);
+        for (size_t i = 0; i < report.rows * report.columns; ++i) coins_reached[i].store(0, std::memory_order_relaxed);
+    }
+
+    level_report run() {
+        auto started = std::chrono::steady_clock::now();
+
+        std::vector<uint64_t> frontier = {pack_state(start)};
+        visited.reserve(1);
+        visited.insert(frontier[0]);
+
+        // Layer n holds the states after n frames; the search runs out with the level timer
+        for (long frame = 0; frame < MAX_LEVEL_TIME && !frontier.empty(); ++frame) {
+            visited.reserve(frontier.size() * ACTION_COUNT);
+            frontier = expand(frontier);
+            if (exit_reached.load() && report.exit_frame < 0) report.exit_frame = frame + 1;
+        }
+
+        report.explored_states = visited.size();
+        for (size_t row = 0; row < report.rows; ++row) {
+            for (size_t column = 0; column < report.columns; ++column) {
+                if (level.get_cell(row, column) == COIN && !coins_reached[row * report.columns + column].load()) {
+                    report.unreachable_coins.push_back({row, column});
+                }
+            }
+        }
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return report;
+    }
+
+private:
+    // Left, none or right, each with and without jumping
+    static constexpr int ACTION_COUNT = 6;
+
+    // One GAME_STATE frame of the player, without enemies and moving colliders.
+    // Returns false if the player dies or reaches the exit, which both end the search there.
+    bool step(player_state &state, int action) {
+        const TileBitplanes &tiles = level.get_bitplanes();
+
+        const float horizontal = static_cast<float>(action % 3 - 1) * PLAYER_MOVEMENT_SPEED;
+        if (horizontal != 0.0f) {
+            state.pos.x = tiles.sweep<SOLID_TRAIT>(state.pos, {horizontal, 0.0f}).position.x;
+        }
+        if (action >= 3 && state.on_ground) state.y_velocity = -JUMP_STRENGTH;
+
+        // Player::update_player_gravity
+        float reach = state.y_velocity >= 0 ? state.y_velocity + GROUND_SNAP_DISTANCE : state.y_velocity;
+        SweepResult sweep = tiles.sweep<SOLID_TRAIT>(state.pos, {0.0f, reach});
+        state.on_ground = sweep.hit && sweep.normal.y < 0;
+        if (state.on_ground) {
+            state.pos.y = sweep.position.y;
+            state.y_velocity = 0;
+        } else if (sweep.hit) {
+            state.pos.y = sweep.position.y;
+            state.y_velocity = CEILING_BOUNCE_OFF;
+        } else {
+            state.pos.y += state.y_velocity;
+            state.y_velocity += GRAVITY_FORCE;
+        }
+
+        // Player::update_players
+        TileContacts contacts = tiles.query(state.pos);
+        for (uint8_t i = 0; i < contacts.count; ++i) {
+            if (contacts.cell_kinds[i] == COIN_TILE) {
+                coins_reached[contacts.cells[i].row * report.columns + contacts.cells[i].column].store(1, std::memory_order_relaxed);
+            }
+        }
+        if (contacts.touches_any<GOAL_TRAIT>()) {
+            exit_reached.store(true, std::memory_order_relaxed);
+            return false;
+        }
+        return !contacts.touches_any<LETHAL_TRAIT>() && state.pos.y <= static_cast<float>(report.rows);
+    }
+
+    void expand_range(const std::vector<uint64_t> &frontier, std::atomic<size_t> &cursor, std::vector<uint64_t> &next) {
+        for (size_t first; (first = cursor.fetch_add(LAYER_BLOCK)) < frontier.size();) {
+            size_t last = std::min(first + LAYER_BLOCK, frontier.size());
+            for (size_t i = first; i < last; ++i) {
+                const player_state state = unpack_state(frontier[i]);
+                for (int action = 0; action < ACTION_COUNT; ++action) {
+                    // Jumping only does something on the ground
+                    if (action >= 3 && !state.on_ground) break;
+
+                    player_state moved = state;
+                    if (!step(moved, action)) continue;
+                    uint64_t key = pack_state(moved);
+                    if (visited.insert(key)) next.push_back(key);
+                }
+            }
+        }
+    }
+
+    std::vector<uint64_t> expand(const std::vector<uint64_t> &frontier) {
+        std::atomic<size_t> cursor{0};
+        if (threads == 1 || frontier.size() < PARALLEL_LAYER_SIZE) {
+            std::vector<uint64_t> next;
+            expand_range(frontier, cursor, next);
+            return next;
+        }
+
+        std::vector<std::vector<uint64_t>> parts(threads);
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < threads; ++i) {
+            workers.emplace_back([&, i] { expand_range(frontier, cursor, parts[i]); });
+        }
+        expand_range(frontier, cursor, parts[0]);
+        for (std::thread &worker : workers) worker.join();
+
+        std::vector<uint64_t> next;
+        for (const std::vector<uint64_t> &part : parts) next.insert(next.end(), part.begin(), part.end());
+        return next;
+    }
+
+    Level level;
+    player_state start{};
+    size_t threads;
+    visited_states visited;
+    std::unique_ptr<std::atomic<uint8_t>[]> coins_reached;
+    std::atomic<bool> exit_reached{false};
+    level_report report;
+};
+
+int main(int argc, char **argv) {
+    std::string path = "data/levels.rll";
+    size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--threads" && i + 1 < argc) {
+            threads = std::stoul(argv[++i]);
+        } else {
+            path = argument;
+        }
+    }
+
+    std::vector<CompressedTileGrid> levels;
+    try {
+        levels = LevelController::getInstanceLevel().loadLevelsFromFile(path);
+    } catch (const std::string &error) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    } catch (const std::exception &error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+
+    bool all_solvable = true;
+    for (size_t i = 0; i < levels.size(); ++i) {
+        level_report report;
+        try {
+            report = level_analyzer(levels[i], threads).run();
+        } catch (const std::exception &error) {
+            std::printf("Level %zu: %s\n", i + 1, error.what());
+            all_solvable = false;
+            continue;
+        }
+
+        std::printf("Level %zu (%zux%zu): ", i + 1, report.columns, report.rows);
+        if (report.exit_frame >= 0) {
+            std::printf("exit reachable in %ld frames (%.1f s of %d s)", report.exit_frame,
+                        static_cast<double>(report.exit_frame) / 60.0, MAX_LEVEL_TIME / 60);
+        } else {
+            std::printf("exit NOT reachable within %d s", MAX_LEVEL_TIME / 60);
+            all_solvable = false;
+        }
+        std::printf(", %zu of %zu coins reachable, %zu states in %.2f s\n",
+                    report.coin_count - report.unreachable_coins.size(), report.coin_count,
+                    report.explored_states, report.seconds);
+        for (const LevelCell &coin : report.unreachable_coins) {
+            std::printf("    unreachable coin at row %zu, column %zu\n", coin.row, coin.column);
+        }
+    }
+    return all_solvable ? 0 : 1;
+}
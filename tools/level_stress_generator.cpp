@@ -0,0 +1,164 @@
+// Writes large random levels in the .rll format, for benchmarks and stress runs.
+//
+//   level_stress_generator [options] > levels.rll
+//     --width N       columns per level, including the side walls (default 256)
+//     --height N      rows per level, including the floor and ceiling (default 16)
+//     --levels N      levels to write (default 1)
+//     --air F         share of the inner cells left empty, 0 to 1 (default 0.8)
+//     --enemies F     chance for each cell on top of a wall to get an enemy (default 0.02)
+//     --coins F       chance for each other free cell to get a coin (default 0.01)
+//     --seed N        (default 1)
+//     --out PATH      write to a file instead of stdout
+//
+// Every level is parsed back with LevelController::parseLevelRLE before it is written,
+// so the output is always something the game can load.
+
+#include "level_controller.h"
+#include "tiles.h"
+#include "graphics.h"
+#include "assets.h"
+#include "split_mix.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct stress_options {
+    size_t width = 256;
+    size_t height = 16;
+    size_t levels = 1;
+    double air = 0.8;
+    double enemies = 0.02;
+    double coins = 0.01;
+    uint64_t seed = 1;
+    std::string out;
+};
+
+stress_options parse_options(int argc, char **argv) {
+    stress_options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string name = argv[i];
+        if (i + 1 >= argc) throw std::runtime_error("Missing value for " + name);
+        std::string value = argv[++i];
+
+        if (name == "--width") options.width = std::stoul(value);
+        else if (name == "--height") options.height = std::stoul(value);
+        else if (name == "--levels") options.levels = std::stoul(value);
+        else if (name == "--air") options.air = std::stod(value);
+        else if (name == "--enemies") options.enemies = std::stod(value);
+        else if (name == "--coins") options.coins = std::stod(value);
+        else if (name == "--seed") options.seed = std::stoull(value);
+        else if (name == "--out") options.out = value;
+        else throw std::runtime_error("Unknown option: " + name);
+    }
+
+    if (options.width < 8 || options.height < 4) throw std::runtime_error("Levels must be at least 8 by 4");
+    if (options.air < 0.0 || options.air > 1.0) throw std::runtime_error("--air must be between 0 and 1");
+    return options;
+}
+
+// Rows of tiles with walls all around, the player at the left and the exit at the right
+std::vector<std::string> generate_level(const stress_options &options, SplitMix64 &random) {
+    const size_t width = options.width;
+    const size_t height = options.height;
+    std::vector<std::string> rows(height, std::string(width, AIR));
+
+    // Walls come in horizontal runs averaging 6 tiles, like ledges, until the air share is met
+    for (size_t row = 1; row + 1 < height; ++row) {
+        size_t column = 1;
+        while (column + 1 < width) {
+            size_t length = 1;
+            while (length < width && random.chance() > 1.0 / 6.0) ++length;
+            length = std::min(length, width - 1 - column);
+            char tile = random.chance() < options.air ? AIR : WALL;
+            rows[row].replace(column, length, length, tile);
+            column += length;
+        }
+    }
+    for (size_t column = 0; column < width; ++column) {
+        rows[0][column] = WALL;
+        rows[height - 1][column] = WALL;
+    }
+    for (size_t row = 0; row < height; ++row) {
+        rows[row][0] = WALL;
+        rows[row][width - 1] = WALL;
+    }
+
+    // Keep a corridor along the floor clear, so the two ends are connected
+    for (size_t column = 1; column + 1 < width; ++column) {
+        rows[height - 2][column] = AIR;
+        rows[height - 3][column] = AIR;
+    }
+
+    // Enemies stand on walls, coins float anywhere else. The corridor gets no enemies, as one
+    // pacing it would make the exit unreachable.
+    for (size_t row = 1; row + 1 < height; ++row) {
+        const bool in_corridor = row + 3 >= height;
+        for (size_t column = 1; column + 1 < width; ++column) {
+            if (rows[row][column] != AIR) continue;
+            if (rows[row + 1][column] == WALL) {
+                if (!in_corridor && random.chance() < options.enemies) rows[row][column] = ENEMY;
+            } else if (random.chance() < options.coins) {
+                rows[row][column] = COIN;
+            }
+        }
+    }
+
+    rows[height - 2][1] = PLAYER;
+    rows[height - 2][2] = AIR;
+    rows[height - 2][width - 2] = EXIT;
+    return rows;
+}
+
+std::string encode_rle(const std::vector<std::string> &rows) {
+    std::string rle;
+    for (size_t row = 0; row < rows.size(); ++row) {
+        if (row > 0) rle += '|';
+        const std::string &cells = rows[row];
+        for (size_t column = 0; column < cells.size();) {
+            size_t end = cells.find_first_not_of(cells[column], column);
+            if (end == std::string::npos) end = cells.size();
+            if (end - column > 1) rle += std::to_string(end - column);
+            rle += cells[column];
+            column = end;
+        }
+    }
+    return rle;
+}
+
+int main(int argc, char **argv) {
+    try {
+        const stress_options options = parse_options(argc, argv);
+
+        std::ofstream file;
+        if (!options.out.empty()) {
+            file.open(options.out);
+            if (!file.is_open()) throw std::runtime_error("Could not open file: " + options.out);
+        }
+        std::ostream &out = options.out.empty() ? std::cout : file;
+
+        // The same seed gives the same levels everywhere
+        SplitMix64 random(options.seed);
+        for (size_t level = 0; level < options.levels; ++level) {
+            const std::string rle = encode_rle(generate_level(options, random));
+
+            // Round-trip through the game's own parser
+            CompressedTileGrid parsed = LevelController::getInstanceLevel().parseLevelRLE(rle);
+            if (parsed.get_rows() != options.height || parsed.get_columns() != options.width) {
+                throw std::runtime_error("Generated level does not parse back to its own size");
+            }
+
+            out << "; Level " << level + 1 << ": " << options.width << "x" << options.height
+                << ", seed " << options.seed << ", " << parsed.get_run_count() << " runs\n";
+            out << rle << '\n';
+        }
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,172 @@
+// Plays two rollback sessions against each other in one process, over a loopback transport with
+// artificial latency, jitter and loss, and checks that both sides end up with the same game.
+//
+//   rollback_soak [levels.rll] [--frames N] [--latency TICKS] [--jitter TICKS] [--loss P] [--seed S]
+//
+// Each side keeps its own copy of the world and swaps it into the game's globals for its turn.
+// Inputs are random but held for a while, like a player's, so prediction is right most of the time.
+// The checksums of every confirmed frame are compared; the slowest frame, rollback included, is
+// reported against the frame budget.
+//
+// Exits with 1 if the two sides diverged.
+
+#include "game.h"
+#include "rollback.h"
+#include "player.h"
+#include "level_controller.h"
+#include "globals.h"
+#include "graphics.h"
+#include "assets.h"
+#include "split_mix.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct soak_options {
+    std::string path = "data/levels.rll";
+    uint64_t frames = 36000;
+    uint32_t latency = 4;
+    uint32_t jitter = 2;
+    double loss = 0.05;
+    uint64_t seed = 1;
+};
+
+// A player mashing away: a new combination of buttons every few frames
+class random_player {
+public:
+    explicit random_player(uint64_t seed)
+        : random(seed) {}
+
+    frame_input next() {
+        if (hold_frames == 0) {
+            const uint64_t roll = random.next();
+            uint8_t held = 0;
+            if (roll % 100 < 70) held |= 1 << MOVE_RIGHT_ACTION;
+            else if (roll % 100 < 85) held |= 1 << MOVE_LEFT_ACTION;
+            if ((roll >> 8) % 100 < 30) held |= 1 << JUMP_ACTION;
+            input.pressed = static_cast<uint8_t>(held & ~input.held);
+            input.held = held;
+            hold_frames = 1 + (roll >> 16) % 20;
+        } else {
+            input.pressed = 0;
+        }
+        --hold_frames;
+
+        // Menus and the death screen need a confirm now and then, and pausing is part of the game too
+        const uint64_t roll = random.next() % 1000;
+        if (roll < 20) input.pressed |= 1 << CONFIRM_ACTION;
+        else if (roll < 22) input.pressed |= 1 << BACK_ACTION;
+        return input;
+    }
+
+private:
+    SplitMix64 random;
+    frame_input input{};
+    uint64_t hold_frames = 0;
+};
+
+struct soak_peer {
+    soak_peer(size_t player, uint64_t seed)
+        : session(std::make_unique<RollbackSession>(transport, player)), world(std::make_unique<game_snapshot>()),
+          input(seed), player(player) {}
+
+    LoopbackTransport transport;
+    std::unique_ptr<RollbackSession> session;
+    std::unique_ptr<game_snapshot> world;
+    random_player input;
+    size_t player;
+    std::vector<uint64_t> checksums; // One per confirmed frame
+};
+
+soak_options parse_options(int argc, char **argv) {
+    soak_options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::runtime_error("Missing value for " + argument);
+            return argv[++i];
+        };
+
+        if (argument == "--frames") options.frames = std::stoull(value());
+        else if (argument == "--latency") options.latency = static_cast<uint32_t>(std::stoul(value()));
+        else if (argument == "--jitter") options.jitter = static_cast<uint32_t>(std::stoul(value()));
+        else if (argument == "--loss") options.loss = std::stod(value());
+        else if (argument == "--seed") options.seed = std::stoull(value());
+        else if (argument.rfind("--", 0) == 0) throw std::runtime_error("Unknown option: " + argument);
+        else options.path = argument;
+    }
+    return options;
+}
+
+int main(int argc, char **argv) {
+    soak_options options;
+    try {
+        options = parse_options(argc, argv);
+        LevelController::getInstanceLevel().loadLevelsFromFile(options.path);
+    } catch (const std::exception &error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+
+    // Both sides start from the same first level
+    player_count = 2;
+    game_state = GAME_STATE;
+    LevelController::getInstanceLevel().load_level(0);
+
+    soak_peer peers[2] = {{0, options.seed * 2 + 1}, {1, options.seed * 2 + 2}};
+    LoopbackTransport::connect(peers[0].transport, peers[1].transport);
+    for (soak_peer &peer : peers) {
+        peer.transport.set_conditions(options.latency, options.jitter, options.loss, options.seed ^ (peer.player + 1) * 0x5851F42D4C957F2Dull);
+        save_game(*peer.world);
+    }
+
+    using clock = std::chrono::steady_clock;
+    const double budget_ms = 1000.0 / TARGET_FPS;
+    double slowest_ms = 0.0;
+
+    for (uint64_t frame = 0; frame < options.frames; ++frame) {
+        for (soak_peer &peer : peers) {
+            restore_game(*peer.world);
+            local_player = peer.player;
+
+            const clock::time_point start = clock::now();
+            peer.session->advance(peer.input.next());
+            slowest_ms = std::max(slowest_ms, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+
+            save_game(*peer.world);
+            while (peer.checksums.size() < peer.session->get_checksum_count()) {
+                peer.checksums.push_back(peer.session->get_checksum(peer.checksums.size()));
+            }
+            peer.transport.tick();
+        }
+    }
+
+    const size_t compared = std::min(peers[0].checksums.size(), peers[1].checksums.size());
+    const auto diverged = std::mismatch(peers[0].checksums.begin(), peers[0].checksums.begin() + compared,
+                                        peers[1].checksums.begin());
+    bool passed = true;
+
+    for (const soak_peer &peer : peers) {
+        const RollbackSession &session = *peer.session;
+        std::printf("Player %zu: %llu frames, %zu confirmed, %llu rollbacks replaying %llu frames, %llu stalls\n",
+                    peer.player + 1, static_cast<unsigned long long>(session.get_frame()), peer.checksums.size(),
+                    static_cast<unsigned long long>(session.get_rollback_count()),
+                    static_cast<unsigned long long>(session.get_resimulated_frames()),
+                    static_cast<unsigned long long>(session.get_stall_count()));
+    }
+    if (diverged.first != peers[0].checksums.begin() + compared) {
+        std::printf("DIVERGED at frame %zu\n", static_cast<size_t>(diverged.first - peers[0].checksums.begin()));
+        passed = false;
+    } else {
+        std::printf("%zu confirmed frames identical on both sides\n", compared);
+    }
+    std::printf("Slowest frame %.2f ms of %.2f ms\n", slowest_ms, budget_ms);
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+// Converts the frame telemetry the game writes (telemetry.bin) to CSV.
+//
+//   telemetry_to_csv telemetry.bin [--stutters | --histogram] > frames.csv
+//     (default)     one row per recorded frame, times in microseconds
+//     --stutters    the frames around each stutter, numbered by snapshot
+//     --histogram   frame count per millisecond of frame time
+//
+// A summary goes to stderr.
+
+#include "frame_telemetry.h"
+
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+void print_frame_header(const char *prefix) {
+    std::printf("%sframe,begin_us,input_us,update_us,draw_us,present_us,frame_us,state,level,stutter\n", prefix);
+}
+
+// Phase columns are durations, not the offsets stored in the file
+void print_frame(const frame_record &record) {
+    const uint32_t *ends = record.phase_end_us;
+    std::printf("%llu,%lld,%u,%u,%u,%u,%u,%u,%d,%u\n",
+                static_cast<unsigned long long>(record.frame), static_cast<long long>(record.begin_us),
+                ends[INPUT_PHASE], ends[UPDATE_PHASE] - ends[INPUT_PHASE], ends[DRAW_PHASE] - ends[UPDATE_PHASE],
+                ends[PRESENT_PHASE] - ends[DRAW_PHASE], ends[PRESENT_PHASE],
+                static_cast<unsigned>(record.state), static_cast<int>(record.level), static_cast<unsigned>(record.stutter));
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: telemetry_to_csv telemetry.bin [--stutters | --histogram]\n";
+        return 1;
+    }
+    const std::string mode = argc == 3 ? argv[2] : "";
+
+    try {
+        if (!mode.empty() && mode != "--stutters" && mode != "--histogram") {
+            throw std::runtime_error("Unknown option: " + mode);
+        }
+        const telemetry_file telemetry = FrameTelemetry::read(argv[1]);
+
+        if (mode == "--stutters") {
+            print_frame_header("snapshot,");
+            for (size_t snapshot = 0; snapshot < telemetry.snapshots.size(); ++snapshot) {
+                for (const frame_record &record : telemetry.snapshots[snapshot].frames) {
+                    std::printf("%zu,", snapshot);
+                    print_frame(record);
+                }
+            }
+        } else if (mode == "--histogram") {
+            std::map<uint32_t, size_t> buckets;
+            for (const frame_record &record : telemetry.frames) {
+                ++buckets[record.phase_end_us[PRESENT_PHASE] / 1000];
+            }
+            std::printf("frame_ms,frames\n");
+            for (const auto &[milliseconds, frames] : buckets) {
+                std::printf("%u,%zu\n", milliseconds, frames);
+            }
+        } else {
+            print_frame_header("");
+            for (const frame_record &record : telemetry.frames) {
+                print_frame(record);
+            }
+        }
+
+        std::fprintf(stderr, "%llu frames, %llu stutters over %.1f ms; %zu frames and %zu stutter snapshots in the file\n",
+                     static_cast<unsigned long long>(telemetry.total_frames),
+                     static_cast<unsigned long long>(telemetry.stutter_count),
+                     telemetry.budget_us * FrameTelemetry::STUTTER_TOLERANCE / 1000.0,
+                     telemetry.frames.size(), telemetry.snapshots.size());
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
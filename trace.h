@@ -0,0 +1,252 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Scoped profiling zones. TRACE_ZONE("name") times the rest of the enclosing scope, counts
+// the heap allocations made in it and records both into a ring buffer owned by the calling
+// thread; the newest seconds of every thread can then be written out as a Chrome trace
+// (chrome://tracing or ui.perfetto.dev). Without PLATFORMER_TRACE the macros expand to nothing.
+
+#ifdef PLATFORMER_TRACE
+
+#include "heap_counter.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(trace_zone_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) TraceRecorder::getInstance().name_thread(name)
+
+inline const double TRACE_DUMP_SECONDS = 10.0;
+
+// Zones of one thread, oldest overwritten first. Only the owning thread writes; a dump may
+// read at the same time and drops whatever the writer could have overwritten meanwhile.
+class TraceRing {
+public:
+    static constexpr size_t CAPACITY = 1 << 15; // About half a minute of zones at 60 fps
+
+    struct event {
+        const char *name;
+        int64_t start;
+        int64_t end;
+        size_t allocations; // Made on this thread inside the zone, nested zones included
+    };
+
+    void push(const event &zone);
+
+    // Appends the events that ended at or after since, oldest first
+    void snapshot(int64_t since, std::vector<event> &out) const;
+
+    std::string thread_name;
+    bool in_use = false;
+
+private:
+    struct slot {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<int64_t> start{0};
+        std::atomic<int64_t> end{0};
+        std::atomic<size_t> allocations{0};
+    };
+
+    std::array<slot, CAPACITY> slots;
+    std::atomic<uint64_t> begun{0};   // Events the writer has started to store
+    std::atomic<uint64_t> written{0}; // Events fully stored
+};
+
+class TraceRecorder {
+public:
+    [[nodiscard]] static TraceRecorder &getInstance() {
+        static TraceRecorder instance;
+        return instance;
+    }
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder operator=(const TraceRecorder&) = delete;
+
+    // Nanoseconds since the recorder was created
+    [[nodiscard]] int64_t now() const;
+
+    void record(const TraceRing::event &zone);
+    void name_thread(const std::string &name);
+
+    // Writes every zone that ended within the last seconds; returns false if the file could not be opened
+    bool write_chrome_trace(const std::string &path, double seconds);
+
+private:
+    // Rings for the main thread and the workers (audio, chunk streamer, frame capture) are made up
+    // front, so a worker's first zone does not allocate in the middle of play
+    static constexpr size_t PREALLOCATED_RINGS = 4;
+    static constexpr size_t MAX_RINGS = 16;
+
+    TraceRecorder();
+    ~TraceRecorder() = default;
+
+    // Hands the ring back for reuse when its thread exits, e.g. when the chunk streamer restarts
+    struct thread_ring {
+        TraceRing *ring = nullptr;
+        ~thread_ring();
+    };
+
+    TraceRing &ring_for_this_thread();
+
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    // Only taken when a thread records its first zone, exits or a trace is written
+    std::mutex rings_mutex;
+    std::vector<std::unique_ptr<TraceRing>> rings;
+};
+
+class TraceZone {
+public:
+    explicit TraceZone(const char *zone_name)
+        : name(zone_name), start(TraceRecorder::getInstance().now()), allocations(thread_heap_allocation_count) {}
+
+    ~TraceZone() {
+        TraceRecorder &recorder = TraceRecorder::getInstance();
+        recorder.record({name, start, recorder.now(), thread_heap_allocation_count - allocations});
+    }
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+private:
+    const char *name;
+    int64_t start;
+    size_t allocations;
+};
+
+// --- Inline Definitions ---
+
+inline void TraceRing::push(const event &zone) {
+    const uint64_t index = written.load(std::memory_order_relaxed);
+
+    // Announce the overwrite before doing it, so a concurrent snapshot knows to drop the slot
+    begun.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot &target = slots[index % CAPACITY];
+    target.name.store(zone.name, std::memory_order_relaxed);
+    target.start.store(zone.start, std::memory_order_relaxed);
+    target.end.store(zone.end, std::memory_order_relaxed);
+    target.allocations.store(zone.allocations, std::memory_order_relaxed);
+
+    written.store(index + 1, std::memory_order_release);
+}
+
+inline void TraceRing::snapshot(int64_t since, std::vector<event> &out) const {
+    const uint64_t last = written.load(std::memory_order_acquire);
+    const uint64_t first = last > CAPACITY ? last - CAPACITY : 0;
+
+    std::vector<event> copied;
+    copied.reserve(last - first);
+    for (uint64_t index = first; index < last; ++index) {
+        const slot &source = slots[index % CAPACITY];
+        copied.push_back({source.name.load(std::memory_order_relaxed),
+                          source.start.load(std::memory_order_relaxed),
+                          source.end.load(std::memory_order_relaxed),
+                          source.allocations.load(std::memory_order_relaxed)});
+    }
+
+    // Slots the writer started on while they were being copied may be torn
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t overwritten = begun.load(std::memory_order_relaxed);
+    const uint64_t valid = overwritten > CAPACITY ? overwritten - CAPACITY : 0;
+
+    for (uint64_t index = std::max(first, valid); index < last; ++index) {
+        const event &copy = copied[index - first];
+        if (copy.end >= since) out.push_back(copy);
+    }
+}
+
+inline TraceRecorder::TraceRecorder() {
+    rings.reserve(MAX_RINGS);
+    for (size_t i = 0; i < PREALLOCATED_RINGS; ++i) {
+        rings.push_back(std::make_unique<TraceRing>());
+    }
+}
+
+inline int64_t TraceRecorder::now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+inline void TraceRecorder::record(const TraceRing::event &zone) {
+    ring_for_this_thread().push(zone);
+}
+
+inline void TraceRecorder::name_thread(const std::string &name) {
+    TraceRing &ring = ring_for_this_thread();
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    ring.thread_name = name;
+}
+
+inline TraceRecorder::thread_ring::~thread_ring() {
+    if (ring == nullptr) return;
+    TraceRecorder &recorder = TraceRecorder::getInstance();
+    std::lock_guard<std::mutex> lock(recorder.rings_mutex);
+    ring->in_use = false;
+}
+
+inline TraceRing &TraceRecorder::ring_for_this_thread() {
+    thread_local thread_ring current;
+    if (current.ring != nullptr) return *current.ring;
+
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    size_t index = 0;
+    while (index < rings.size() && rings[index]->in_use) ++index;
+    if (index == rings.size()) rings.push_back(std::make_unique<TraceRing>());
+
+    current.ring = rings[index].get();
+    current.ring->in_use = true;
+    current.ring->thread_name = "thread " + std::to_string(index + 1);
+    return *current.ring;
+}
+
+inline bool TraceRecorder::write_chrome_trace(const std::string &path, double seconds) {
+    const int64_t since = now() - static_cast<int64_t>(seconds * 1e9);
+
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) return false;
+
+    std::fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first = true;
+    std::vector<TraceRing::event> events;
+
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    for (size_t thread = 0; thread < rings.size(); ++thread) {
+        const TraceRing &ring = *rings[thread];
+        std::fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %zu, \"args\": {\"name\": \"%s\"}}",
+                     first ? "" : ",\n", thread + 1, ring.thread_name.c_str());
+        first = false;
+
+        events.clear();
+        ring.snapshot(since, events);
+        for (const TraceRing::event &event : events) {
+            // Complete events in microseconds
+            std::fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %zu, \"ts\": %.3f, \"dur\": %.3f, "
+                               "\"args\": {\"allocations\": %zu}}",
+                         event.name, thread + 1, static_cast<double>(event.start) / 1e3,
+                         static_cast<double>(event.end - event.start) / 1e3, event.allocations);
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    std::fclose(file);
+    return true;
+}
+
+#else
+
+#define TRACE_ZONE(name) ((void) 0)
+#define TRACE_THREAD_NAME(name) ((void) 0)
+
+#endif // PLATFORMER_TRACE
+
+#endif // TRACE_H